@@ -31,6 +31,10 @@ static const char *image2d = "image2d_t";
 static const char *sizeParameterPrefix = "_wcl";
 // must be the same as WebCLConfiguration::sizeParameterType_
 static const char *sizeParameterType = "ulong";
+// must be the same as WebCLConfiguration::constantRegionParameter_
+static const char *constantRegionParameter = "_wcl_constant_region";
+// must be the same as WebCLConfiguration::constantRegionSizeParameter_
+static const char *constantRegionSizeParameter = "_wcl_constant_region_size";
 
 WebCLHeader::WebCLHeader()
     : indentation_("    ")
@@ -54,6 +58,8 @@ void WebCLHeader::emitHeader(std::ostream &out, clv_program program)
     ++level_;
     emitVersion(out);
     out << ",\n";
+    emitHash(out, program);
+    out << ",\n";
     emitKernels(out, program);
     out << "\n";
 
@@ -85,6 +91,20 @@ void WebCLHeader::emitVersion(std::ostream &out)
     emitStringEntry(out, "version", "1.0");
 }
 
+void WebCLHeader::emitHash(std::ostream &out, clv_program program)
+{
+    size_t hashSize = 0;
+    cl_int err = clvGetProgramHash(program, 0, NULL, &hashSize);
+    assert(err == CL_SUCCESS);
+
+    std::string hash(hashSize, '\0');
+    err = clvGetProgramHash(program, hash.size(), &hash[0], NULL);
+    assert(err == CL_SUCCESS);
+    hash.erase(hash.size() - 1);
+
+    emitStringEntry(out, "hash", hash);
+}
+
 void WebCLHeader::emitParameter(
     std::ostream &out,
     const std::string &parameter, int index, const std::string &type,
@@ -148,11 +168,17 @@ namespace {
     {
         return std::string(sizeParameterPrefix) + "_" + arrayParamName + "_size";
     }
+
+    std::string buildMaskParameterName(const std::string &arrayParamName)
+    {
+        return std::string(sizeParameterPrefix) + "_" + arrayParamName + "_mask";
+    }
 }
 
 void WebCLHeader::emitArrayParameter(
     std::ostream &out,
-    const std::string &name, int index, const std::string &type, cl_kernel_arg_address_qualifier addressQual)
+    const std::string &name, int index, const std::string &type, cl_kernel_arg_address_qualifier addressQual,
+    bool isPadded, bool inConstantRegion)
 {
     emitIndentation(out);
     out << "\"" << name << "\"" << " :\n";
@@ -183,7 +209,15 @@ void WebCLHeader::emitArrayParameter(
     }
     out << ",\n";
 
-    emitStringEntry(out, "size-parameter", buildSizeParameterName(name));
+    if (inConstantRegion) {
+        emitStringEntry(out, "constant-region", constantRegionParameter);
+    } else if (isPadded) {
+        emitStringEntry(out, "padded-size", "power-of-two");
+        out << ",\n";
+        emitStringEntry(out, "mask-parameter", buildMaskParameterName(name));
+    } else {
+        emitStringEntry(out, "size-parameter", buildSizeParameterName(name));
+    }
     out << "\n";
 
     --level_;
@@ -192,6 +226,43 @@ void WebCLHeader::emitArrayParameter(
     --level_;
 }
 
+void WebCLHeader::emitConstantRegion(
+    std::ostream &out,
+    int index, const std::vector<std::string> &members)
+{
+    emitIndentation(out);
+    out << "\"" << constantRegionParameter << "\"" << " :\n";
+    ++level_;
+    emitIndentation(out);
+    out << "{\n";
+    ++level_;
+
+    emitNumberEntry(out, "index", index);
+    out << ",\n";
+    emitStringEntry(out, "type", "uchar *");
+    out << ",\n";
+    emitStringEntry(out, "address-space", "constant");
+    out << ",\n";
+    emitStringEntry(out, "size-parameter", constantRegionSizeParameter);
+    out << ",\n";
+    emitStringEntry(out, "member-alignment", "CL_DEVICE_MEM_BASE_ADDR_ALIGN");
+    out << ",\n";
+
+    emitIndentation(out);
+    out << "\"members\" : [";
+    for (std::vector<std::string>::const_iterator i = members.begin(); i != members.end(); ++i)
+        out << ((i == members.begin()) ? " " : ", ") << "\"" << *i << "\"";
+    out << " ]\n";
+
+    --level_;
+    emitIndentation(out);
+    out << "}";
+    --level_;
+
+    out << ",\n";
+    emitParameter(out, constantRegionSizeParameter, index + 1, sizeParameterType);
+}
+
 void WebCLHeader::emitKernel(std::ostream &out, clv_program program, cl_int kernel)
 {
     cl_int err = CL_SUCCESS;
@@ -215,6 +286,7 @@ void WebCLHeader::emitKernel(std::ostream &out, clv_program program, cl_int kern
     cl_int numArgs = clvGetKernelArgCount(program, kernel);
     assert(numArgs >= 0);
     unsigned index = 0;
+    std::vector<std::string> constantRegionMembers;
     for (cl_int arg = 0; arg < numArgs; ++arg) {
         if (arg != 0)
             out << ",\n";
@@ -244,16 +316,30 @@ void WebCLHeader::emitKernel(std::ostream &out, clv_program program, cl_int kern
             emitBuiltinParameter(out, name, index, type, clvGetKernelArgAccessQual(program, kernel, arg));
         } else if (clvKernelArgIsPointer(program, kernel, arg)) {
             // memory objects
-            emitArrayParameter(out, name, index, type, clvGetKernelArgAddressQual(program, kernel, arg));
-            ++index;
-            out << ",\n";
-            emitParameter(out, buildSizeParameterName(name), index, sizeParameterType);
+            const bool isPadded = clvKernelArgIsPadded(program, kernel, arg) == CL_TRUE;
+            const bool inConstantRegion = clvKernelArgIsInConstantRegion(program, kernel, arg) == CL_TRUE;
+            emitArrayParameter(out, name, index, type, clvGetKernelArgAddressQual(program, kernel, arg),
+                               isPadded, inConstantRegion);
+            if (inConstantRegion) {
+                constantRegionMembers.push_back(name);
+            } else {
+                ++index;
+                out << ",\n";
+                emitParameter(out, isPadded ? buildMaskParameterName(name) : buildSizeParameterName(name),
+                              index, sizeParameterType);
+            }
         } else {
             // primitives
             emitParameter(out, name, index, type);
         }
         ++index;
     }
+
+    // The constant region parameters follow the original parameters.
+    if (!constantRegionMembers.empty()) {
+        out << ",\n";
+        emitConstantRegion(out, index, constantRegionMembers);
+    }
     out << "\n";
 
     --level_;
@@ -27,6 +27,7 @@
 #include <iostream>
 #include <map>
 #include <string>
+#include <vector>
 
 #include <clv/clv.h>
 
@@ -55,6 +56,10 @@ private:
     /// -> "version" : "1.0"
     void emitVersion(std::ostream &out);
 
+    /// Emits digest of the validated program to the given stream:
+    /// -> "hash" : "e3b0c442..."
+    void emitHash(std::ostream &out, clv_program program);
+
     /// Contains optional "key" : "string" entries for parameters.
     typedef std::map<std::string, std::string> Fields;
 
@@ -89,10 +94,42 @@ private:
     ///           "address-space" : "global",
     ///           "size-parameter" : "_wcl_foo_size"
     ///         }
+    ///
+    /// Memory objects that must be padded to a power of two number of
+    /// elements have a mask parameter instead of a size parameter:
+    ///
+    ///           "padded-size" : "power-of-two",
+    ///           "mask-parameter" : "_wcl_foo_mask"
+    ///
+    /// Constant memory objects that are bound into the constant
+    /// region refer to the region instead:
+    ///
+    ///           "constant-region" : "_wcl_constant_region"
     void emitArrayParameter(
         std::ostream &out,
         const std::string &name, int index, const std::string &type,
-        cl_kernel_arg_address_qualifier addressQual);
+        cl_kernel_arg_address_qualifier addressQual, bool isPadded,
+        bool inConstantRegion);
+
+    /// Emits the constant region parameters of a kernel to the given
+    /// stream:
+    /// "__constant float *foo, __constant int *bar"
+    /// ->
+    /// "_wcl_constant_region" : {
+    ///                            "index" : 2,
+    ///                            "type" : "uchar *",
+    ///                            "address-space" : "constant",
+    ///                            "size-parameter" : "_wcl_constant_region_size",
+    ///                            "member-alignment" : "CL_DEVICE_MEM_BASE_ADDR_ALIGN",
+    ///                            "members" : [ "foo", "bar" ]
+    ///                          },
+    /// "_wcl_constant_region_size" : { "index" : 3, "type" : "ulong" }
+    ///
+    /// The members are sub-buffers of the region, in the given order,
+    /// at offsets aligned to the base address alignment of the device.
+    void emitConstantRegion(
+        std::ostream &out,
+        int index, const std::vector<std::string> &members);
 
     /// Emits kernel and its parameters to the given stream:
     /// "__kernel void foo(...)"
@@ -196,12 +196,22 @@ int main(int argc, char const* argv[])
     }
     userDefines.push_back(0);
 
+    // Parse requested kernels
+    std::vector<const char *> kernelNames;
+    for (int i = 2; i < argc; ++i) {
+        char const *option = argv[i];
+        std::string cmd = "--kernel=";
+        if (!std::string(option).substr(0, cmd.size()).compare(cmd))
+            kernelNames.push_back(option + cmd.size());
+    }
+    kernelNames.push_back(0);
+
     // TODO: handle arguments like -ferror-limit as webcl-validator CLI specific options;
     // that specific one should affect error printing
 
     // Run validator
     cl_int err = CL_SUCCESS;
-    clv_program prog = clvValidate(inputSource.c_str(), &extensions[0], &userDefines[0], NULL, NULL, &err);
+    clv_program prog = clvValidateKernels(inputSource.c_str(), &extensions[0], &userDefines[0], &kernelNames[0], NULL, NULL, &err);
     
     for (std::vector<const char *>::const_iterator it = extensions.begin();
          it != extensions.end();
@@ -64,6 +64,18 @@ CLV_API clv_program CLV_CALL clvValidate(
     void *notify_data,
     cl_int *errcode_ret);
 
+// Run validation, keeping only the kernels listed in the NULL
+// terminated kernel_names array and the code that they use. All
+// kernels are kept if kernel_names is NULL or empty.
+CLV_API clv_program CLV_CALL clvValidateKernels(
+    const char *input_source,
+    const char **active_extensions,
+    const char **user_defines,
+    const char **kernel_names,
+    void (CL_CALLBACK *pfn_notify)(clv_program program, void *user_data),
+    void *notify_data,
+    cl_int *errcode_ret);
+
 typedef enum {
     /// Callback used, validation still running
     CLV_PROGRAM_VALIDATING,
@@ -178,6 +190,23 @@ CLV_API cl_kernel_arg_address_qualifier CLV_CALL clvGetKernelArgAddressQual(
     cl_uint kernel,
     cl_uint arg);
 
+// Determine if the given pointer kernel argument must be padded to a
+// power of two number of elements. Padded memory objects are passed
+// with an index mask instead of a size.
+CLV_API cl_bool CLV_CALL clvKernelArgIsPadded(
+    clv_program program,
+    cl_uint kernel,
+    cl_uint arg);
+
+// Determine if the given constant pointer kernel argument must be
+// bound into the constant region of the kernel. Such memory objects
+// have no size argument. Instead, the kernel takes a pointer to the
+// whole region and its size in bytes after its last argument.
+CLV_API cl_bool CLV_CALL clvKernelArgIsInConstantRegion(
+    clv_program program,
+    cl_uint kernel,
+    cl_uint arg);
+
 // Determine if the given kernel argument is an image
 CLV_API cl_bool CLV_CALL clvKernelArgIsImage(
     clv_program program,
@@ -197,6 +226,15 @@ CLV_API cl_int CLV_CALL clvGetProgramValidatedSource(
     char *source_buf,
     size_t *source_size_ret);
 
+// Get a SHA-256 digest of the validated source and kernel metadata as
+// 64 hexadecimal digits. Programs with equal digests can share compiled
+// binaries. Empty if validation failed.
+CLV_API cl_int CLV_CALL clvGetProgramHash(
+    clv_program program,
+    size_t hash_buf_size,
+    char *hash_buf,
+    size_t *hash_size_ret);
+
 // Release resources allocated by clvValidate()
 CLV_API void CLV_CALL clvReleaseProgram(
     clv_program program);
@@ -363,7 +363,8 @@ void WebCLMatcher2Action::ExecuteAction()
     }
 }
 
-WebCLValidatorAction::WebCLValidatorAction(std::string &validatedSource, WebCLAnalyser::KernelList &kernels)
+WebCLValidatorAction::WebCLValidatorAction(std::string &validatedSource, WebCLAnalyser::KernelList &kernels,
+                                           std::string &programHash)
     : WebCLAction()
     , consumer_(0)
     , transformer_(0)
@@ -371,6 +372,7 @@ WebCLValidatorAction::WebCLValidatorAction(std::string &validatedSource, WebCLAn
     , sema_(0)
     , validatedSource_(validatedSource)
     , kernels_(kernels)
+    , programHash_(programHash)
 {
 }
 
@@ -399,6 +401,7 @@ void WebCLValidatorAction::ExecuteAction()
     ParseAST(*sema.get());
     validatedSource_ = consumer_->getTransformedSource();
     kernels_ = consumer_->getKernels();
+    programHash_ = consumer_->getProgramHash();
 }
 
 bool WebCLValidatorAction::usesPreprocessorOnly() const
@@ -206,7 +206,8 @@ class WebCLValidatorAction : public WebCLAction
 {
 public:
 
-    WebCLValidatorAction(std::string &validatedSource, WebCLAnalyser::KernelList &kernels);
+    WebCLValidatorAction(std::string &validatedSource, WebCLAnalyser::KernelList &kernels,
+                         std::string &programHash);
     virtual ~WebCLValidatorAction();
 
     /// \see clang::FrontendAction
@@ -239,6 +240,8 @@ private:
     std::string &validatedSource_;
     /// Ditto for kernel info
     WebCLAnalyser::KernelList &kernels_;
+    /// Ditto for digest of validated source and kernel info
+    std::string &programHash_;
 };
 
 #endif // WEBCLVALIDATOR_WEBCLACTION
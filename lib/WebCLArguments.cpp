@@ -144,11 +144,12 @@ WebCLArguments::WebCLArguments(const std::string &inputSource, const CharPtrVect
     const int numValidatorOptions =
         sizeof(validatorOptions) / sizeof(validatorOptions[0]);
 
-    std::set<char const *> userDefines;
+    // keep command line order, later definitions override earlier ones
+    std::vector<char const *> userDefines;
     for (size_t i = 0; i < argv.size(); ++i) {
         char const *option = argv[i];
         if (!std::string(option).substr(0, 2).compare("-D"))
-            userDefines.insert(option);
+            userDefines.push_back(option);
     }
 
     // find used extensions arguments
@@ -51,7 +51,7 @@ namespace {
     }
 }
 
-WebCLConfiguration::WebCLConfiguration()
+WebCLConfiguration::WebCLConfiguration(bool compact)
     : typePrefix_("_Wcl")
     , variablePrefix_("_wcl")
     , macroPrefix_("_WCL")
@@ -59,7 +59,7 @@ WebCLConfiguration::WebCLConfiguration()
 
     , minSuffix_("min")
     , maxSuffix_("max")
-    , indentation_("    ")
+    , indentation_(compact ? "" : "    ")
     , sizeParameterType_("ulong")
 
     , privateAddressSpace_("private")
@@ -81,6 +81,10 @@ WebCLConfiguration::WebCLConfiguration()
     , localMaxField_(variablePrefix_ + "_locals_max")
     , constantMinField_(variablePrefix_ + "_constant_allocations_min")
     , constantMaxField_(variablePrefix_ + "_constant_allocations_max")
+    , constantRegionParameter_(variablePrefix_ + "_constant_region")
+    , constantRegionSizeParameter_(constantRegionParameter_ + "_size")
+    , constantRegionMinField_(constantRegionParameter_ + "_" + minSuffix_)
+    , constantRegionMaxField_(constantRegionParameter_ + "_" + maxSuffix_)
 
     , privatesField_("pa")
     , localLimitsField_("ll")
@@ -91,14 +95,24 @@ WebCLConfiguration::WebCLConfiguration()
     , constantRecordName_(variablePrefix_ + "_constant_allocations")
     , programRecordName_(variablePrefix_ + "_allocations_allocation")
     , addressSpaceRecordName_(variablePrefix_ + "_allocs")
+    , addressSpaceRecordQualifiers_("const restrict")
 
     , nullType_("uint")
     , privateNullField_("pn")
     , localNullField_("ln")
     , constantNullField_("cn")
     , globalNullField_("gn")
+    , localTableField_("lt")
+    , constantTableField_("ct")
+    , globalTableField_("gt")
 
     , localRangeZeroingMacro_(macroPrefix_ + "_LOCAL_RANGE_INIT")
+    , localRangeFillMacro_(macroPrefix_ + "_LOCAL_RANGE_FILL")
+    , localItemIndexVariable_(variablePrefix_ + "_local_item_index")
+    , localItemCountVariable_(variablePrefix_ + "_local_item_count")
+    , privateRangeZeroingMacro_(macroPrefix_ + "_PRIVATE_RANGE_ZERO")
+    , limitTableSetMacro_(macroPrefix_ + "_SET_LIMIT")
+    , limitTableSortMacro_(macroPrefix_ + "_SORT_LIMITS")
 
     , dataWidths_(generateWidths(2, 16) + 3)
     , roundingModes_(StringList() + "rte" + "rtz" + "rtp" + "rtn")
@@ -251,6 +265,18 @@ const std::string WebCLConfiguration::getNameOfSizeParameter(const std::string &
     return variablePrefix_ + "_" + arrayParamName + "_size";
 }
 
+const std::string WebCLConfiguration::getNameOfMaskParameter(const std::string &arrayParamName) const
+{
+    return variablePrefix_ + "_" + arrayParamName + "_mask";
+}
+
+const std::string WebCLConfiguration::getNameOfCheckedPointer(unsigned serial) const
+{
+    std::ostringstream out;
+    out << variablePrefix_ << "_checked_ptr_" << serial;
+    return out.str();
+}
+
 const std::string WebCLConfiguration::getNameOfAnonymousStructure(const clang::RecordDecl *decl)
 {
     static const std::string name = "Struct";
@@ -332,9 +358,35 @@ const std::string WebCLConfiguration::getReferenceToRelocatedVariable(const clan
       break;
   }
 
+  std::map<const clang::VarDecl*, std::string>::const_iterator path =
+      relocatedVariablePaths_.find(decl);
+  if (path != relocatedVariablePaths_.end())
+      prefix += path->second;
+
   return prefix + getNameOfRelocatedVariable(decl);
 }
 
+const std::string WebCLConfiguration::getNameOfSlotField(unsigned slot) const
+{
+    // Renamed user variables are either "_wcl_name" or
+    // "_wcl_N_name". A number that isn't followed by the separator
+    // can't come from them.
+    std::ostringstream out;
+    out << variablePrefix_ << "_" << slot << "slot";
+    return out.str();
+}
+
+const std::string WebCLConfiguration::getNameOfSlotGroupField(const std::string &function) const
+{
+    return variablePrefix_ + "_" + function;
+}
+
+void WebCLConfiguration::setPathOfRelocatedVariable(
+    const clang::VarDecl *decl, const std::string &path)
+{
+    relocatedVariablePaths_[decl] = path;
+}
+
 const std::string WebCLConfiguration::getIndentation(unsigned int levels) const
 {
     std::string indentation;
@@ -344,29 +396,46 @@ const std::string WebCLConfiguration::getIndentation(unsigned int levels) const
 }
 
 const std::string WebCLConfiguration::getStaticLimitRef(unsigned addressSpaceNum, std::string cast) const
+{
+    if (addressSpaceNum == clang::LangAS::opencl_global) {
+        assert(false && "There can't be static allocations in global address space.");
+        return "0, 0";
+    }
+
+    return getStaticLimitBoundRef(addressSpaceNum, false, cast) + ", " +
+        getStaticLimitBoundRef(addressSpaceNum, true, cast);
+}
+
+const std::string WebCLConfiguration::getStaticLimitBoundRef(unsigned addressSpaceNum, bool isMax, std::string cast) const
 {
     std::string prefix = addressSpaceRecordName_ + "->";
 
     switch (addressSpaceNum) {
     case clang::LangAS::opencl_constant:
         prefix += constantLimitsField_ + ".";
-        return cast + prefix + constantMinField_ + ", " + cast + prefix + constantMaxField_;
+        return cast + prefix + (isMax ? constantMaxField_ : constantMinField_);
 
     case clang::LangAS::opencl_local:
         prefix += localLimitsField_ + ".";
-        return cast + prefix + localMinField_ + ", " + cast + prefix + localMaxField_;
+        return cast + prefix + (isMax ? localMaxField_ : localMinField_);
 
     case clang::LangAS::opencl_global:
         assert(false && "There can't be static allocations in global address space.");
-        return "0, 0";
+        return "0";
 
     default:
         prefix += privatesField_;
-        return cast + "&" + prefix + ", " + cast + "(&" + prefix + " + 1)";
+        return isMax ? (cast + "(&" + prefix + " + 1)") : (cast + "&" + prefix);
     }
 }
 
 const std::string WebCLConfiguration::getDynamicLimitRef(const clang::VarDecl *decl, std::string cast) const
+{
+    return getDynamicLimitBoundRef(decl, false, cast) + ", " +
+        getDynamicLimitBoundRef(decl, true, cast);
+}
+
+const std::string WebCLConfiguration::getDynamicLimitBoundRef(const clang::VarDecl *decl, bool isMax, std::string cast) const
 {
     std::string prefix = addressSpaceRecordName_ + "->";
 
@@ -385,12 +454,38 @@ const std::string WebCLConfiguration::getDynamicLimitRef(const clang::VarDecl *d
         break;
     }
 
-    prefix += ".";
+    return cast + prefix + "." + getNameOfLimitField(decl, isMax);
+}
+
+const std::string WebCLConfiguration::getRegionLimitRef(std::string cast) const
+{
+    return getRegionLimitBoundRef(false, cast) + ", " + getRegionLimitBoundRef(true, cast);
+}
+
+const std::string WebCLConfiguration::getRegionLimitBoundRef(bool isMax, std::string cast) const
+{
+    return cast + addressSpaceRecordName_ + "->" + constantLimitsField_ + "." +
+        (isMax ? constantRegionMaxField_ : constantRegionMinField_);
+}
+
+const std::string WebCLConfiguration::getNameOfLimitTableField(unsigned addressSpaceNum) const
+{
+    switch (addressSpaceNum) {
+    case clang::LangAS::opencl_global:
+        return globalTableField_;
+    case clang::LangAS::opencl_constant:
+        return constantTableField_;
+    case clang::LangAS::opencl_local:
+        return localTableField_;
+    default:
+        assert(false && "Private address space doesn't have a limit table.");
+        return "";
+    }
+}
 
-    std::stringstream retVal;
-    retVal << cast << prefix << getNameOfLimitField(decl, false) << ", "
-           << cast << prefix << getNameOfLimitField(decl, true);
-    return retVal.str();
+const std::string WebCLConfiguration::getLimitTableRef(unsigned addressSpaceNum) const
+{
+    return addressSpaceRecordName_ + "->" + getNameOfLimitTableField(addressSpaceNum);
 }
 
 const std::string WebCLConfiguration::getNullLimitRef(unsigned addressSpaceNum) const
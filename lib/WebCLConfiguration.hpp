@@ -29,6 +29,7 @@
 
 #include "clang/AST/Type.h"
 
+#include <map>
 #include <string>
 
 namespace clang {
@@ -44,7 +45,8 @@ class WebCLConfiguration
 {
 public:
 
-    WebCLConfiguration();
+    /// Generated code isn't indented in compact mode.
+    explicit WebCLConfiguration(bool compact = false);
     ~WebCLConfiguration();
 
     /// \return Address space name (with the leading "__" omitted).
@@ -100,6 +102,12 @@ public:
     /// \return Name of kernel parameter that contains the size of
     /// the array parameter with the given name.
     const std::string getNameOfSizeParameter(const std::string &arrayParamName) const;
+    /// \return Name of kernel parameter that contains the index mask
+    /// of the padded array parameter with the given name.
+    const std::string getNameOfMaskParameter(const std::string &arrayParamName) const;
+    /// \return Name of variable that holds a checked pointer, which
+    /// can be reused by identical memory accesses.
+    const std::string getNameOfCheckedPointer(unsigned serial) const;
     /// \return Name that should be generated for given anonymous or
     /// nameless structure.
     const std::string getNameOfAnonymousStructure(const clang::RecordDecl *decl);
@@ -116,6 +124,15 @@ public:
     /// \return Reference to a variable that was relocated to an
     /// address space record.
     const std::string getReferenceToRelocatedVariable(const clang::VarDecl *decl);
+    /// \return Name of union field that contains the structures of
+    /// functions sharing the given slot.
+    const std::string getNameOfSlotField(unsigned slot) const;
+    /// \return Name of structure field that contains the relocated
+    /// variables of the given function within a shared slot.
+    const std::string getNameOfSlotGroupField(const std::string &function) const;
+    /// Places a relocated variable into a nested field of its
+    /// address space record, e.g. "_wcl_0slot._wcl_foo.".
+    void setPathOfRelocatedVariable(const clang::VarDecl *decl, const std::string &path);
     /// \return The default whitespace sequence repeated the given
     /// number of times.
     const std::string getIndentation(unsigned int levels) const;
@@ -123,11 +140,27 @@ public:
     /// \return Minimum and maximum limits of an address space
     /// structure.
     const std::string getStaticLimitRef(unsigned addressSpaceNum, std::string cast = "") const;
+    /// \return Minimum or maximum limit of an address space
+    /// structure.
+    const std::string getStaticLimitBoundRef(unsigned addressSpaceNum, bool isMax, std::string cast = "") const;
     /// \return Minimum and maximum limits of a memory object passed
     /// to a kernel.
     const std::string getDynamicLimitRef(const clang::VarDecl *decl, std::string cast = "") const;
+    /// \return Minimum or maximum limit of a memory object passed
+    /// to a kernel.
+    const std::string getDynamicLimitBoundRef(const clang::VarDecl *decl, bool isMax, std::string cast = "") const;
+    /// \return Minimum and maximum limits of the constant region.
+    const std::string getRegionLimitRef(std::string cast = "") const;
+    /// \return Minimum or maximum limit of the constant region.
+    const std::string getRegionLimitBoundRef(bool isMax, std::string cast = "") const;
     /// \return Minimum and maximum limits of a null memory area.
     const std::string getNullLimitRef(unsigned addressSpaceNum) const;
+    /// \return Name of the field that contains the sorted table of
+    /// limits of an address space.
+    const std::string getNameOfLimitTableField(unsigned addressSpaceNum) const;
+    /// \return Reference to the sorted table of limits of an address
+    /// space.
+    const std::string getLimitTableRef(unsigned addressSpaceNum) const;
 
     /// \return Stripped version of str in purpose of using it as an identifier
     /// Currently only handles spaces and asterisks. The generated sequences
@@ -182,6 +215,13 @@ public:
     const std::string localMaxField_;
     const std::string constantMinField_;
     const std::string constantMaxField_;
+    /// Kernel parameters that point to the region into which constant
+    /// memory objects are bound and give its size in bytes, and the
+    /// limits of the region.
+    const std::string constantRegionParameter_;
+    const std::string constantRegionSizeParameter_;
+    const std::string constantRegionMinField_;
+    const std::string constantRegionMaxField_;
 
     /// Fields of the main allocation structure needed for determining
     /// memory area limits.
@@ -198,6 +238,8 @@ public:
     const std::string programRecordName_;
     /// Name used to refer to main allocation structure.
     const std::string addressSpaceRecordName_;
+    /// Qualifiers of restricted pointers to main allocation structure.
+    const std::string addressSpaceRecordQualifiers_;
 
     /// Basic unit of null areas.
     const std::string nullType_;
@@ -206,9 +248,25 @@ public:
     const std::string localNullField_;
     const std::string constantNullField_;
     const std::string globalNullField_;
+    /// Sorted tables of limits, which are searched when an address
+    /// space has many limits.
+    const std::string localTableField_;
+    const std::string constantTableField_;
+    const std::string globalTableField_;
 
     /// Name of macro for zeroing local memory areas.
     const std::string localRangeZeroingMacro_;
+    /// Name of macro for filling local memory areas with vector
+    /// stores, and names of the variables holding the flattened
+    /// work-item index and work-group size that it's given.
+    const std::string localRangeFillMacro_;
+    const std::string localItemIndexVariable_;
+    const std::string localItemCountVariable_;
+    /// Name of macro for zeroing private memory areas.
+    const std::string privateRangeZeroingMacro_;
+    /// Names of macros for filling and sorting limit tables.
+    const std::string limitTableSetMacro_;
+    const std::string limitTableSortMacro_;
 
     // List of data widths: 2, 4, 8, 16
     const UintList dataWidths_;
@@ -237,6 +295,9 @@ private:
     WebCLRenamer typedefRenamer_;
     /// Name generator for anonymous or nameless structures.
     WebCLRenamer anonymousStructureRenamer_;
+    /// Nested fields of relocated variables that aren't placed
+    /// directly into their address space record.
+    std::map<const clang::VarDecl*, std::string> relocatedVariablePaths_;
 };
 
 #endif // WEBCLVALIDATOR_WEBCLCONFIGURATION
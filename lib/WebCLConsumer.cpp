@@ -36,6 +36,7 @@ WebCLConsumer::WebCLConsumer(
     , restrictor_(instance)
     , analyser_(instance)
     , visitors_()
+    , unusedCodeHandler_(instance, analyser_, transformer)
     , inputNormaliser_(instance, analyser_, transformer)
     , addressSpaceHandler_(instance, analyser_, transformer)
     , kernelHandler_(instance, analyser_, transformer, addressSpaceHandler_)
@@ -50,6 +51,10 @@ WebCLConsumer::WebCLConsumer(
     // Collects information about nodes.
     visitors_.push_back(&analyser_);
 
+    // Removes helper functions and constants that kernels don't use
+    // so that other passes don't need to handle them.
+    passes_.push_back(&unusedCodeHandler_);
+
     // Checks that when image types are being used, they always originate from
     // function parameters
     passes_.push_back(&imageSampleSafetyHandler_);
@@ -114,6 +119,11 @@ const std::string &WebCLConsumer::getTransformedSource() const
     return printer_.getOutput();
 }
 
+const std::string &WebCLConsumer::getProgramHash() const
+{
+    return printer_.getHash();
+}
+
 const WebCLAnalyser::KernelList &WebCLConsumer::getKernels() const
 {
     return analyser_.getKernelFunctions();
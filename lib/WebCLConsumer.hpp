@@ -51,6 +51,9 @@ public:
     /// Get transformed source
     const std::string &getTransformedSource() const;
 
+    /// Get digest of transformed source and kernel info
+    const std::string &getProgramHash() const;
+
     /// Get kernel info
     const WebCLAnalyser::KernelList &getKernels() const;
 
@@ -74,6 +77,7 @@ private:
     Visitors visitors_;
 
     /// Transformation passes.
+    WebCLUnusedCodeHandler unusedCodeHandler_;
     WebCLInputNormaliser inputNormaliser_;
     WebCLAddressSpaceHandler addressSpaceHandler_;
     WebCLKernelHandler kernelHandler_;
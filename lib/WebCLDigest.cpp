@@ -0,0 +1,185 @@
+/*
+** Copyright (c) 2013 The Khronos Group Inc.
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and/or associated documentation files (the
+** "Materials"), to deal in the Materials without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Materials, and to
+** permit persons to whom the Materials are furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be included
+** in all copies or substantial portions of the Materials.
+**
+** THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+** TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+** MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+*/
+
+
+#include "WebCLDigest.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    const uint32_t roundConstants[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    inline uint32_t rotateRight(uint32_t value, unsigned bits)
+    {
+        return (value >> bits) | (value << (32 - bits));
+    }
+}
+
+WebCLDigest::WebCLDigest()
+    : length_(0)
+    , blockSize_(0)
+{
+    state_[0] = 0x6a09e667;
+    state_[1] = 0xbb67ae85;
+    state_[2] = 0x3c6ef372;
+    state_[3] = 0xa54ff53a;
+    state_[4] = 0x510e527f;
+    state_[5] = 0x9b05688c;
+    state_[6] = 0x1f83d9ab;
+    state_[7] = 0x5be0cd19;
+}
+
+WebCLDigest::~WebCLDigest()
+{
+}
+
+void WebCLDigest::update(const char *data, size_t size)
+{
+    length_ += size;
+
+    while (size > 0) {
+        const size_t count = std::min(size, sizeof(block_) - blockSize_);
+        std::memcpy(block_ + blockSize_, data, count);
+        blockSize_ += count;
+        data += count;
+        size -= count;
+
+        if (blockSize_ == sizeof(block_)) {
+            transform(block_);
+            blockSize_ = 0;
+        }
+    }
+}
+
+void WebCLDigest::update(const std::string &data)
+{
+    update(data.data(), data.size());
+}
+
+std::string WebCLDigest::final()
+{
+    const uint64_t bits = length_ * 8;
+
+    // Pad with a single one bit and zeros so that the message length
+    // fits at the end of the last block.
+    const char one = static_cast<char>(0x80);
+    update(&one, 1);
+    const char zero = 0;
+    while (blockSize_ != sizeof(block_) - 8)
+        update(&zero, 1);
+
+    char length[8];
+    for (unsigned i = 0; i < 8; ++i)
+        length[i] = static_cast<char>(bits >> (56 - 8 * i));
+    update(length, sizeof(length));
+
+    static const char hexDigits[] = "0123456789abcdef";
+    std::string result;
+    for (unsigned i = 0; i < 8; ++i) {
+        for (int shift = 28; shift >= 0; shift -= 4)
+            result += hexDigits[(state_[i] >> shift) & 0xf];
+    }
+    return result;
+}
+
+void WebCLDigest::transform(const unsigned char *block)
+{
+    uint32_t schedule[64];
+    for (unsigned i = 0; i < 16; ++i) {
+        schedule[i] =
+            (static_cast<uint32_t>(block[4 * i]) << 24) |
+            (static_cast<uint32_t>(block[4 * i + 1]) << 16) |
+            (static_cast<uint32_t>(block[4 * i + 2]) << 8) |
+            static_cast<uint32_t>(block[4 * i + 3]);
+    }
+    for (unsigned i = 16; i < 64; ++i) {
+        const uint32_t s0 =
+            rotateRight(schedule[i - 15], 7) ^ rotateRight(schedule[i - 15], 18) ^ (schedule[i - 15] >> 3);
+        const uint32_t s1 =
+            rotateRight(schedule[i - 2], 17) ^ rotateRight(schedule[i - 2], 19) ^ (schedule[i - 2] >> 10);
+        schedule[i] = schedule[i - 16] + s0 + schedule[i - 7] + s1;
+    }
+
+    uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+    uint32_t e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+    for (unsigned i = 0; i < 64; ++i) {
+        const uint32_t s1 = rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25);
+        const uint32_t choice = (e & f) ^ (~e & g);
+        const uint32_t temp1 = h + s1 + choice + roundConstants[i] + schedule[i];
+        const uint32_t s0 = rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22);
+        const uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+        const uint32_t temp2 = s0 + majority;
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp1;
+        d = c;
+        c = b;
+        b = a;
+        a = temp1 + temp2;
+    }
+
+    state_[0] += a;
+    state_[1] += b;
+    state_[2] += c;
+    state_[3] += d;
+    state_[4] += e;
+    state_[5] += f;
+    state_[6] += g;
+    state_[7] += h;
+}
+
+WebCLDigestStream::WebCLDigestStream(llvm::raw_ostream &out, WebCLDigest &digest)
+    : llvm::raw_ostream(true) // unbuffered, nothing to flush at destruction
+    , out_(out)
+    , digest_(digest)
+    , position_(0)
+{
+}
+
+WebCLDigestStream::~WebCLDigestStream()
+{
+}
+
+void WebCLDigestStream::write_impl(const char *ptr, size_t size)
+{
+    out_.write(ptr, size);
+    digest_.update(ptr, size);
+    position_ += size;
+}
+
+uint64_t WebCLDigestStream::current_pos() const
+{
+    return position_;
+}
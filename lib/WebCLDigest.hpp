@@ -0,0 +1,86 @@
+#ifndef WEBCLVALIDATOR_WEBCLDIGEST
+#define WEBCLVALIDATOR_WEBCLDIGEST
+
+/*
+** Copyright (c) 2013 The Khronos Group Inc.
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and/or associated documentation files (the
+** "Materials"), to deal in the Materials without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Materials, and to
+** permit persons to whom the Materials are furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be included
+** in all copies or substantial portions of the Materials.
+**
+** THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+** TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+** MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+*/
+
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <string>
+
+/// Computes a SHA-256 digest incrementally.
+class WebCLDigest
+{
+public:
+
+    WebCLDigest();
+    ~WebCLDigest();
+
+    /// Adds data to the digest.
+    void update(const char *data, size_t size);
+    void update(const std::string &data);
+
+    /// Completes the digest. No data can be added afterwards.
+    ///
+    /// \return Digest as a string of 64 hexadecimal digits.
+    std::string final();
+
+private:
+
+    /// Processes a complete 64 byte block.
+    void transform(const unsigned char *block);
+
+    /// Intermediate hash value.
+    uint32_t state_[8];
+    /// Number of bytes added so far.
+    uint64_t length_;
+    /// Bytes that don't yet fill a complete block.
+    unsigned char block_[64];
+    size_t blockSize_;
+};
+
+/// Forwards output to another stream and adds it to a digest on the
+/// way, so that the digest doesn't need a second pass over the
+/// output.
+class WebCLDigestStream : public llvm::raw_ostream
+{
+public:
+
+    WebCLDigestStream(llvm::raw_ostream &out, WebCLDigest &digest);
+    virtual ~WebCLDigestStream();
+
+private:
+
+    /// \see llvm::raw_ostream
+    virtual void write_impl(const char *ptr, size_t size);
+    /// \see llvm::raw_ostream
+    virtual uint64_t current_pos() const;
+
+    llvm::raw_ostream &out_;
+    WebCLDigest &digest_;
+    /// Number of bytes written so far.
+    uint64_t position_;
+};
+
+#endif // WEBCLVALIDATOR_WEBCLDIGEST
@@ -23,8 +23,38 @@
 
 #include "WebCLHelper.hpp"
 
+#include "clang/AST/Expr.h"
+
+namespace {
+    /// Raw encodings of source locations are assigned in the order
+    /// the sources are read, so they are stable between runs.
+    bool isBefore(clang::SourceLocation lhsBegin, clang::SourceLocation lhsEnd, const void *lhs,
+                  clang::SourceLocation rhsBegin, clang::SourceLocation rhsEnd, const void *rhs)
+    {
+        if (lhsBegin != rhsBegin)
+            return lhsBegin.getRawEncoding() < rhsBegin.getRawEncoding();
+        if (lhsEnd != rhsEnd)
+            return lhsEnd.getRawEncoding() < rhsEnd.getRawEncoding();
+        // nodes without distinct locations, e.g. implicit ones
+        return lhs < rhs;
+    }
+}
+
+bool SourceLocationOrder::operator()(const clang::Decl *lhs, const clang::Decl *rhs) const
+{
+    return isBefore(lhs->getLocation(), lhs->getLocEnd(), lhs,
+                    rhs->getLocation(), rhs->getLocEnd(), rhs);
+}
+
+bool SourceLocationOrder::operator()(const clang::Stmt *lhs, const clang::Stmt *rhs) const
+{
+    return isBefore(lhs->getLocStart(), lhs->getLocEnd(), lhs,
+                    rhs->getLocStart(), rhs->getLocEnd(), rhs);
+}
+
 AddressSpaceLimits::AddressSpaceLimits(unsigned addressSpace)
     : hasStaticLimits_(false)
+    , hasRegionLimits_(false)
     , addressSpace_(addressSpace)
 {
 }
@@ -48,6 +78,16 @@ bool AddressSpaceLimits::hasStaticallyAllocatedLimits()
     return hasStaticLimits_;
 }
 
+void AddressSpaceLimits::setRegionLimits(bool hasRegionLimits)
+{
+    hasRegionLimits_ = hasRegionLimits;
+}
+
+bool AddressSpaceLimits::hasRegionLimits()
+{
+    return hasRegionLimits_;
+}
+
 unsigned AddressSpaceLimits::getAddressSpace()
 {
     return addressSpace_;
@@ -55,15 +95,38 @@ unsigned AddressSpaceLimits::getAddressSpace()
   
 bool AddressSpaceLimits::empty()
 {
-    return !hasStaticLimits_ && dynamicLimits_.empty();
+    return !hasStaticLimits_ && !hasRegionLimits_ && dynamicLimits_.empty();
 }
 
 unsigned AddressSpaceLimits::count()
 {
-    return dynamicLimits_.size() + (hasStaticallyAllocatedLimits() ? 1 : 0);
+    return dynamicLimits_.size() + (hasStaticallyAllocatedLimits() ? 1 : 0) +
+        (hasRegionLimits() ? 1 : 0);
 }
     
 AddressSpaceLimits::LimitList &AddressSpaceLimits::getDynamicLimits()
 {
     return dynamicLimits_;
 }
+
+BaseIndexField::BaseIndexField(clang::Expr *access)
+    : base(access), index(NULL), field()
+{
+    if (clang::MemberExpr *memberExpr = llvm::dyn_cast<clang::MemberExpr>(access)) {
+        base = memberExpr->getBase();
+        field = memberExpr->getMemberNameInfo().getName().getAsString();
+
+    } else if (clang::ExtVectorElementExpr *vecExpr =
+               llvm::dyn_cast<clang::ExtVectorElementExpr>(access)) {
+        base = vecExpr->getBase();
+        field = vecExpr->getAccessor().getName().str();
+
+    } else if (clang::ArraySubscriptExpr *arraySubExpr =
+               llvm::dyn_cast<clang::ArraySubscriptExpr>(access)) {
+        base = arraySubExpr->getBase();
+        index = arraySubExpr->getIdx();
+
+    } else if (clang::UnaryOperator *unary = llvm::dyn_cast<clang::UnaryOperator>(access)) {
+        base = unary->getSubExpr();
+    }
+}
@@ -24,13 +24,26 @@
 ** MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
 */
 
+#include <string>
 #include <vector>
 
 namespace clang {
+    class Decl;
+    class Expr;
     class ParmVarDecl;
+    class Stmt;
     class VarDecl;
 }
 
+/// Orders declarations and statements by their source locations.
+/// Used for containers of AST nodes so that iterating over them, and
+/// therefore the generated code, doesn't depend on heap addresses.
+struct SourceLocationOrder
+{
+    bool operator()(const clang::Decl *lhs, const clang::Decl *rhs) const;
+    bool operator()(const clang::Stmt *lhs, const clang::Stmt *rhs) const;
+};
+
 /// Represents all relocated variables. The variables are ordered so
 /// that the corresponding address space structure can be padded.
 typedef std::vector<clang::VarDecl*> AddressSpaceInfo;
@@ -38,6 +51,8 @@ typedef std::vector<clang::VarDecl*> AddressSpaceInfo;
 /// Represents all disjoint memory areas of an address space.
 /// - Static areas consist of relocated variables.
 /// - Dynamic areas consist of kernel memory object parameters.
+/// - The constant region contains the constant memory object
+///   parameters that the host binds into a single memory area.
 ///
 /// Used to write limit structures and initializers for the address
 /// space.
@@ -59,6 +74,13 @@ public:
     /// through the address space structure.
     bool hasStaticallyAllocatedLimits();
 
+    /// Inform whether memory object parameters are bound into the
+    /// constant region instead of having their own limits.
+    void setRegionLimits(bool hasRegionLimits);
+    /// \return Whether the address space contains the constant
+    /// region.
+    bool hasRegionLimits();
+
     /// \return Address space.
     unsigned getAddressSpace();
 
@@ -78,10 +100,25 @@ private:
 
     /// Whether variables have been relocated.
     bool hasStaticLimits_;
+    /// Whether memory object parameters are bound into a region.
+    bool hasRegionLimits_;
     /// Identifies the address space.
     unsigned addressSpace_;
     /// Disjoint memory areas passed as kernel parameters.
     LimitList dynamicLimits_;
 };
 
+/// Splits a memory access into the pointer that is dereferenced, an
+/// optional index and an optional field or vector component name:
+///
+/// base[index], *base, base->field
+struct BaseIndexField
+{
+    BaseIndexField(clang::Expr *access);
+
+    clang::Expr *base;
+    clang::Expr *index;
+    std::string  field;
+};
+
 #endif // WEBCLVALIDATOR_WEBCLHELPER
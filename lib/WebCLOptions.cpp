@@ -0,0 +1,120 @@
+
+/*
+** Copyright (c) 2013 The Khronos Group Inc.
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and/or associated documentation files (the
+** "Materials"), to deal in the Materials without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Materials, and to
+** permit persons to whom the Materials are furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be included
+** in all copies or substantial portions of the Materials.
+**
+** THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+** TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+** MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+*/
+
+#include "WebCLOptions.hpp"
+
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Lex/PreprocessorOptions.h"
+
+#include <cstdlib>
+
+const char *WebCLOptions::reuseChecks_ = "WCLV_REUSE_CHECKS";
+const char *WebCLOptions::coalesceChecks_ = "WCLV_COALESCE_CHECKS";
+const char *WebCLOptions::constantIndices_ = "WCLV_CONSTANT_INDICES";
+const char *WebCLOptions::clampIndices_ = "WCLV_CLAMP_INDICES";
+const char *WebCLOptions::unsignedOffsetChecks_ = "WCLV_UNSIGNED_OFFSET_CHECKS";
+const char *WebCLOptions::searchLimits_ = "WCLV_SEARCH_LIMITS";
+const char *WebCLOptions::paddedBuffers_ = "WCLV_PADDED_BUFFERS";
+const char *WebCLOptions::padLocals_ = "WCLV_PAD_LOCALS";
+const char *WebCLOptions::restrictAllocs_ = "WCLV_RESTRICT_ALLOCS";
+const char *WebCLOptions::escapeAnalysis_ = "WCLV_ESCAPE_ANALYSIS";
+const char *WebCLOptions::shareSlots_ = "WCLV_SHARE_SLOTS";
+const char *WebCLOptions::fusedLocalZeroing_ = "WCLV_FUSED_LOCAL_ZEROING";
+const char *WebCLOptions::skipWrittenLocals_ = "WCLV_SKIP_WRITTEN_LOCALS";
+const char *WebCLOptions::lazyPrivates_ = "WCLV_LAZY_PRIVATES";
+const char *WebCLOptions::removeUnusedCode_ = "WCLV_REMOVE_UNUSED_CODE";
+const char *WebCLOptions::selectiveAllocs_ = "WCLV_SELECTIVE_ALLOCS";
+const char *WebCLOptions::kernels_ = "WCLV_KERNELS";
+const char *WebCLOptions::compactOutput_ = "WCLV_COMPACT_OUTPUT";
+const char *WebCLOptions::inlineVectorChecks_ = "WCLV_INLINE_VECTOR_CHECKS";
+const char *WebCLOptions::constantRegion_ = "WCLV_CONSTANT_REGION";
+
+WebCLOptions::WebCLOptions(clang::CompilerInstance &instance)
+    : options_()
+{
+    typedef std::vector< std::pair<std::string, bool> > MacroList;
+    const MacroList &macros = instance.getPreprocessorOpts().Macros;
+
+    // later definitions override earlier ones like they do on the
+    // command line
+    for (MacroList::const_iterator i = macros.begin(); i != macros.end(); ++i) {
+        const std::string &macro = i->first;
+        const bool isUndef = i->second;
+
+        const std::string::size_type equals = macro.find('=');
+        const std::string name = macro.substr(0, equals);
+
+        if (isUndef) {
+            options_.erase(name);
+        } else if (equals == std::string::npos) {
+            options_[name] = "1";
+        } else {
+            options_[name] = macro.substr(equals + 1);
+        }
+    }
+}
+
+WebCLOptions::~WebCLOptions()
+{
+}
+
+bool WebCLOptions::isEnabled(const std::string &option) const
+{
+    return options_.count(option) > 0;
+}
+
+unsigned WebCLOptions::getValue(const std::string &option, unsigned defaultValue) const
+{
+    OptionMap::const_iterator i = options_.find(option);
+    if (i == options_.end())
+        return defaultValue;
+
+    const char *value = i->second.c_str();
+    char *end = NULL;
+    const unsigned long number = std::strtoul(value, &end, 0);
+    if ((end == value) || (*end != '\0'))
+        return defaultValue;
+
+    return static_cast<unsigned>(number);
+}
+
+std::vector<std::string> WebCLOptions::getList(const std::string &option) const
+{
+    std::vector<std::string> values;
+    OptionMap::const_iterator i = options_.find(option);
+    if (i == options_.end())
+        return values;
+
+    const std::string &list = i->second;
+    std::string::size_type begin = 0;
+    while (begin <= list.size()) {
+        std::string::size_type end = list.find(',', begin);
+        if (end == std::string::npos)
+            end = list.size();
+        if (end > begin)
+            values.push_back(list.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return values;
+}
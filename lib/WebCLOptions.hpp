@@ -0,0 +1,142 @@
+#ifndef WEBCLVALIDATOR_WEBCLOPTIONS
+#define WEBCLVALIDATOR_WEBCLOPTIONS
+
+
+/*
+** Copyright (c) 2013 The Khronos Group Inc.
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and/or associated documentation files (the
+** "Materials"), to deal in the Materials without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Materials, and to
+** permit persons to whom the Materials are furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be included
+** in all copies or substantial portions of the Materials.
+**
+** THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+** TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+** MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+*/
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace clang {
+    class CompilerInstance;
+}
+
+/// Optional validator behaviour that is selected with preprocessor
+/// definitions in the same way as extensions are, e.g.
+///
+/// webcl-validator kernel.cl -DWCLV_REUSE_CHECKS
+///
+/// Options don't change the safety guarantees of the validated
+/// code. They only select between different ways of generating the
+/// checks.
+class WebCLOptions
+{
+public:
+
+    explicit WebCLOptions(clang::CompilerInstance &instance);
+    ~WebCLOptions();
+
+    /// Reuse clamped pointers of identical memory accesses within
+    /// straight-line code instead of checking each access.
+    static const char *reuseChecks_;
+    /// Check accesses to nearby elements of the same base pointer
+    /// with a single range check.
+    static const char *coalesceChecks_;
+    /// Don't check array accesses with constant indices that are
+    /// within bounds and don't relocate arrays that are accessed
+    /// only that way.
+    static const char *constantIndices_;
+    /// Clamp indices of fixed size arrays to array bounds instead of
+    /// checking the accessed address and don't relocate arrays that
+    /// are only accessed that way.
+    static const char *clampIndices_;
+    /// Check limits by comparing unsigned byte offsets from the start
+    /// of each limit instead of comparing addresses against both
+    /// ends.
+    static const char *unsignedOffsetChecks_;
+    /// Address spaces with more limits than the given value are
+    /// checked with a binary search over limits that are sorted at
+    /// kernel entry.
+    static const char *searchLimits_;
+    /// Require global and constant memory objects to be padded to a
+    /// power of two number of elements and mask indices of accesses
+    /// through the corresponding kernel parameters.
+    static const char *paddedBuffers_;
+    /// Pad local arrays to a power of two number of elements, as
+    /// long as the padding fits into the given number of bytes, and
+    /// mask indices of the padded arrays.
+    static const char *padLocals_;
+    /// Declare pointers to the main allocation structure as const
+    /// restrict pointers so that limits loaded through them can stay
+    /// in registers across stores to memory objects.
+    static const char *restrictAllocs_;
+    /// Don't relocate private variables whose address is only passed
+    /// to builtins or helper functions that can't access anything
+    /// else through it.
+    static const char *escapeAnalysis_;
+    /// Let relocated variables of functions that can't be active at
+    /// the same time share storage.
+    static const char *shareSlots_;
+    /// Fill all local memory ranges with one fused routine that uses
+    /// vector stores, instead of zeroing each range byte by byte.
+    static const char *fusedLocalZeroing_;
+    /// Don't zero local arrays that every work-item writes its part
+    /// of before the first barrier of a kernel.
+    static const char *skipWrittenLocals_;
+    /// Don't zero initialize private variables that a kernel writes
+    /// completely before it can read any private memory.
+    static const char *lazyPrivates_;
+    /// Remove helper functions that no kernel can call and constant
+    /// variables that aren't used.
+    static const char *removeUnusedCode_;
+    /// Add the allocation structure parameter only to helper
+    /// functions that access memory through it, directly or through
+    /// the functions they call.
+    static const char *selectiveAllocs_;
+    /// Comma separated names of the kernels that the validated
+    /// program should contain. Other kernels are removed along with
+    /// the code that only they use.
+    static const char *kernels_;
+    /// Emit only the general definitions that the program refers to,
+    /// and leave out generator comments and indentation.
+    static const char *compactOutput_;
+    /// Check vector loads and stores from address spaces with a
+    /// single limit inside their wrappers instead of calling a limit
+    /// check function.
+    static const char *inlineVectorChecks_;
+    /// Expect the host to bind all constant memory objects of a
+    /// kernel into one region and check accesses through them against
+    /// the limits of that region.
+    static const char *constantRegion_;
+
+    /// \return Whether the option has been defined.
+    bool isEnabled(const std::string &option) const;
+    /// \return Numeric value of the option or the given default
+    /// value if the option hasn't been defined or if the value isn't
+    /// a number.
+    unsigned getValue(const std::string &option, unsigned defaultValue) const;
+    /// \return Comma separated values of the option or an empty
+    /// list if the option hasn't been defined.
+    std::vector<std::string> getList(const std::string &option) const;
+
+private:
+
+    /// Maps option names to their values. Options defined without a
+    /// value map to "1" like preprocessor definitions do.
+    typedef std::map<std::string, std::string> OptionMap;
+    OptionMap options_;
+};
+
+#endif // WEBCLVALIDATOR_WEBCLOPTIONS
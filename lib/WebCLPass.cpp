@@ -27,11 +27,15 @@
 #include "WebCLTransformer.hpp"
 #include "WebCLTypes.hpp"
 #include "WebCLCommon.hpp"
+#include "WebCLOptions.hpp"
 
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Attr.h"
+#include "clang/AST/ParentMap.h"
 #include "clang/Basic/OpenCL.h"
 
+#include <algorithm>
+
 WebCLPass::WebCLPass(
     clang::CompilerInstance &instance,
     WebCLAnalyser &analyser, WebCLTransformer &transformer)
@@ -44,6 +48,236 @@ WebCLPass::~WebCLPass()
 {
 }
 
+WebCLUnusedCodeHandler::WebCLUnusedCodeHandler(
+    clang::CompilerInstance &instance,
+    WebCLAnalyser &analyser, WebCLTransformer &transformer)
+    : WebCLPass(instance, analyser, transformer)
+{
+}
+
+WebCLUnusedCodeHandler::~WebCLUnusedCodeHandler()
+{
+}
+
+void WebCLUnusedCodeHandler::run(clang::ASTContext &context)
+{
+    WebCLOptions options(instance_);
+    const std::vector<std::string> requested = options.getList(WebCLOptions::kernels_);
+    if (requested.empty() && !options.isEnabled(WebCLOptions::removeUnusedCode_))
+        return;
+
+    // Functions and constants may be used only by removed kernels or
+    // functions, so they must be removed in this order.
+    const unsigned kernels = removeUnrequestedKernels(requested);
+    const unsigned functions = removeUnusedHelperFunctions();
+    const unsigned constants = removeUnusedConstantVariables();
+    if (kernels)
+        info("Removed %0 kernels that weren't requested.") << kernels;
+    if (functions || constants) {
+        info("Removed %0 unused helper function declarations and %1 unused constant variables.")
+            << functions << constants;
+    }
+}
+
+namespace {
+    /// Collects the functions that the statement calls directly.
+    void collectCallees(clang::Stmt *stmt, std::vector<clang::FunctionDecl*> &callees)
+    {
+        if (!stmt)
+            return;
+
+        if (clang::CallExpr *call = llvm::dyn_cast<clang::CallExpr>(stmt)) {
+            if (clang::FunctionDecl *callee = call->getDirectCallee())
+                callees.push_back(callee);
+        }
+
+        for (clang::Stmt::child_iterator i = stmt->child_begin(); i != stmt->child_end(); ++i)
+            collectCallees(*i, callees);
+    }
+}
+
+unsigned WebCLUnusedCodeHandler::removeUnrequestedKernels(
+    const std::vector<std::string> &requested)
+{
+    if (requested.empty())
+        return 0;
+
+    // Canonical declarations of requested kernels and of functions,
+    // including other kernels, that they may call.
+    std::set<clang::FunctionDecl*> reachable;
+    // Functions whose calls haven't been followed yet.
+    std::vector<clang::FunctionDecl*> pending;
+
+    std::set<std::string> missing(requested.begin(), requested.end());
+    WebCLAnalyser::KernelList &kernels = analyser_.getKernelFunctions();
+    for (WebCLAnalyser::KernelList::iterator i = kernels.begin();
+         i != kernels.end(); ++i) {
+        if (std::find(requested.begin(), requested.end(), i->name) != requested.end()) {
+            missing.erase(i->name);
+            reachable.insert(i->decl->getCanonicalDecl());
+            pending.push_back(i->decl);
+        }
+    }
+
+    for (std::set<std::string>::iterator i = missing.begin(); i != missing.end(); ++i)
+        error("Requested kernel %0 isn't defined.") << *i;
+
+    while (!pending.empty()) {
+        clang::FunctionDecl *caller = pending.back();
+        pending.pop_back();
+
+        const clang::FunctionDecl *definition = NULL;
+        if (!caller->hasBody(definition))
+            continue;
+
+        std::vector<clang::FunctionDecl*> callees;
+        collectCallees(definition->getBody(), callees);
+        for (std::vector<clang::FunctionDecl*>::iterator i = callees.begin();
+             i != callees.end(); ++i) {
+            if (reachable.insert((*i)->getCanonicalDecl()).second)
+                pending.push_back(*i);
+        }
+    }
+
+    // Functions declared together, e.g. "void f(void), g(void);",
+    // share the text of their declaration. It can be removed only if
+    // none of them is kept.
+    std::set<unsigned> keptDeclarations;
+    WebCLAnalyser::FunctionDeclSet &helpers = analyser_.getHelperFunctions();
+    for (WebCLAnalyser::FunctionDeclSet::iterator i = helpers.begin();
+         i != helpers.end(); ++i) {
+        keptDeclarations.insert((*i)->getLocStart().getRawEncoding());
+    }
+    for (WebCLAnalyser::KernelList::iterator i = kernels.begin();
+         i != kernels.end(); ++i) {
+        if (reachable.count(i->decl->getCanonicalDecl()))
+            keptDeclarations.insert(i->decl->getLocStart().getRawEncoding());
+    }
+
+    // Kernels that requested kernels call are kept.
+    WebCLAnalyser::FunctionDeclSet unrequested;
+    for (WebCLAnalyser::KernelList::iterator i = kernels.begin();
+         i != kernels.end(); ++i) {
+        if (!reachable.count(i->decl->getCanonicalDecl()) &&
+            !keptDeclarations.count(i->decl->getLocStart().getRawEncoding())) {
+            unrequested.insert(i->decl);
+        }
+    }
+
+    analyser_.removeKernelFunctions(unrequested);
+    for (WebCLAnalyser::FunctionDeclSet::iterator i = unrequested.begin();
+         i != unrequested.end(); ++i) {
+        transformer_.removeUnused(*i);
+    }
+    return unrequested.size();
+}
+
+unsigned WebCLUnusedCodeHandler::removeUnusedHelperFunctions()
+{
+    // Canonical declarations of functions that kernels may call
+    // directly or through other functions.
+    std::set<clang::FunctionDecl*> reachable;
+    // Function definitions whose calls haven't been followed yet.
+    std::vector<clang::FunctionDecl*> pending;
+
+    WebCLAnalyser::KernelList &kernels = analyser_.getKernelFunctions();
+    for (WebCLAnalyser::KernelList::iterator i = kernels.begin();
+         i != kernels.end(); ++i) {
+        if (i->decl->doesThisDeclarationHaveABody())
+            pending.push_back(i->decl);
+    }
+
+    WebCLAnalyser::CallExprSet &calls = analyser_.getInternalCalls();
+    while (!pending.empty()) {
+        clang::FunctionDecl *caller = pending.back();
+        pending.pop_back();
+
+        for (WebCLAnalyser::CallExprSet::iterator i = calls.begin();
+             i != calls.end(); ++i) {
+            clang::CallExpr *call = *i;
+            if (!analyser_.isInside(call->getLocStart(), caller))
+                continue;
+
+            clang::FunctionDecl *callee = call->getDirectCallee();
+            if (!reachable.insert(callee->getCanonicalDecl()).second)
+                continue;
+
+            const clang::FunctionDecl *definition = NULL;
+            if (callee->hasBody(definition))
+                pending.push_back(const_cast<clang::FunctionDecl*>(definition));
+        }
+    }
+
+    // Functions declared together, e.g. "int f(int), g(int);", share
+    // the text of their declaration. It can be removed only if none
+    // of them is kept.
+    std::set<unsigned> keptDeclarations;
+    for (WebCLAnalyser::KernelList::iterator i = kernels.begin();
+         i != kernels.end(); ++i) {
+        keptDeclarations.insert(i->decl->getLocStart().getRawEncoding());
+    }
+    WebCLAnalyser::FunctionDeclSet &helpers = analyser_.getHelperFunctions();
+    for (WebCLAnalyser::FunctionDeclSet::iterator i = helpers.begin();
+         i != helpers.end(); ++i) {
+        if (reachable.count((*i)->getCanonicalDecl()))
+            keptDeclarations.insert((*i)->getLocStart().getRawEncoding());
+    }
+
+    // Prototypes are removed along with definitions.
+    WebCLAnalyser::FunctionDeclSet unused;
+    for (WebCLAnalyser::FunctionDeclSet::iterator i = helpers.begin();
+         i != helpers.end(); ++i) {
+        if (!reachable.count((*i)->getCanonicalDecl()) &&
+            !keptDeclarations.count((*i)->getLocStart().getRawEncoding())) {
+            unused.insert(*i);
+        }
+    }
+
+    analyser_.removeHelperFunctions(unused);
+    for (WebCLAnalyser::FunctionDeclSet::iterator i = unused.begin();
+         i != unused.end(); ++i) {
+        transformer_.removeUnused(*i);
+    }
+    return unused.size();
+}
+
+unsigned WebCLUnusedCodeHandler::removeUnusedConstantVariables()
+{
+    std::set<clang::ValueDecl*> used;
+    WebCLAnalyser::DeclRefExprSet &uses = analyser_.getVariableUses();
+    for (WebCLAnalyser::DeclRefExprSet::iterator i = uses.begin();
+         i != uses.end(); ++i) {
+        used.insert((*i)->getDecl());
+    }
+
+    // Variables declared together, e.g. "__constant int a = 0, b = 1;",
+    // share the text of their declaration. They can be removed only
+    // if none of them is used.
+    std::set<unsigned> keptDeclarations;
+    WebCLAnalyser::VarDeclSet &constants = analyser_.getConstantVariables();
+    for (WebCLAnalyser::VarDeclSet::iterator i = constants.begin();
+         i != constants.end(); ++i) {
+        if (used.count(*i))
+            keptDeclarations.insert((*i)->getLocStart().getRawEncoding());
+    }
+
+    WebCLAnalyser::VarDeclSet unused;
+    for (WebCLAnalyser::VarDeclSet::iterator i = constants.begin();
+         i != constants.end(); ++i) {
+        if (!used.count(*i) &&
+            !keptDeclarations.count((*i)->getLocStart().getRawEncoding())) {
+            unused.insert(*i);
+        }
+    }
+
+    analyser_.removeConstantVariables(unused);
+    for (WebCLAnalyser::VarDeclSet::iterator i = unused.begin();
+         i != unused.end(); ++i) {
+        transformer_.removeUnused(*i);
+    }
+    return unused.size();
+}
+
 WebCLInputNormaliser::WebCLInputNormaliser(
     clang::CompilerInstance &instance,
     WebCLAnalyser &analyser, WebCLTransformer &transformer)
@@ -66,8 +300,10 @@ void WebCLInputNormaliser::run(clang::ASTContext &context)
 
 WebCLHelperFunctionHandler::WebCLHelperFunctionHandler(
     clang::CompilerInstance &instance,
-    WebCLAnalyser &analyser, WebCLTransformer &transformer)
+    WebCLAnalyser &analyser, WebCLTransformer &transformer,
+    WebCLAddressSpaceHandler &addressSpaceHandler)
     : WebCLPass(instance, analyser, transformer)
+    , addressSpaceHandler_(addressSpaceHandler)
 {
 }
 
@@ -77,11 +313,23 @@ WebCLHelperFunctionHandler::~WebCLHelperFunctionHandler()
 
 void WebCLHelperFunctionHandler::run(clang::ASTContext &context)
 {
+    const bool selective =
+        WebCLOptions(instance_).isEnabled(WebCLOptions::selectiveAllocs_);
+    FunctionSet usingAllocations;
+    if (selective)
+        findFunctionsUsingAllocations(usingAllocations);
+
     // Go through all non kernel functions and add allocation
     // structure parameter in front of parameter list.
     WebCLAnalyser::FunctionDeclSet &helperFunctions = analyser_.getHelperFunctions();
+    unsigned skipped = 0;
     for (WebCLAnalyser::FunctionDeclSet::iterator i = helperFunctions.begin();
         i != helperFunctions.end(); ++i) {
+        if (selective && !usingAllocations.count((*i)->getCanonicalDecl())) {
+            if ((*i)->doesThisDeclarationHaveABody())
+                ++skipped;
+            continue;
+        }
         transformer_.addRecordParameter(*i);
     }
 
@@ -90,8 +338,87 @@ void WebCLHelperFunctionHandler::run(clang::ASTContext &context)
     WebCLAnalyser::CallExprSet &internalCalls = analyser_.getInternalCalls();
     for (WebCLAnalyser::CallExprSet::iterator i = internalCalls.begin();
         i != internalCalls.end(); ++i) {
+        clang::FunctionDecl *callee = (*i)->getDirectCallee();
+        if (selective && !usingAllocations.count(callee->getCanonicalDecl()))
+            continue;
         transformer_.addRecordArgument(*i);
     }
+
+    if (skipped)
+        info("Left out allocation structure parameter from %0 helper functions.") << skipped;
+}
+
+void WebCLHelperFunctionHandler::findFunctionsUsingAllocations(FunctionSet &functions)
+{
+    // Memory accesses are instrumented with checks against limits
+    // in the allocation structure.
+    WebCLAnalyser::MemoryAccessMap &accesses = analyser_.getPointerAceesses();
+    for (WebCLAnalyser::MemoryAccessMap::iterator i = accesses.begin();
+         i != accesses.end(); ++i) {
+        if (clang::FunctionDecl *helper = getEnclosingHelper(i->first->getLocStart()))
+            functions.insert(helper);
+    }
+
+    // Relocated variables are accessed through the allocation
+    // structure.
+    WebCLAnalyser::DeclRefExprSet &uses = analyser_.getVariableUses();
+    for (WebCLAnalyser::DeclRefExprSet::iterator i = uses.begin();
+         i != uses.end(); ++i) {
+        clang::VarDecl *var = llvm::dyn_cast<clang::VarDecl>((*i)->getDecl());
+        if (!var || (var->getType().getAddressSpace() == clang::LangAS::opencl_global) ||
+            !addressSpaceHandler_.isRelocated(var)) {
+            continue;
+        }
+        if (clang::FunctionDecl *helper = getEnclosingHelper((*i)->getLocStart()))
+            functions.insert(helper);
+    }
+
+    // Wrapper functions may need the allocation structure to check
+    // their arguments.
+    WebCLAnalyser::CallExprSet calls = analyser_.getBuiltinCalls();
+    WebCLAnalyser::CallExprSet &internalCalls = analyser_.getInternalCalls();
+    calls.insert(internalCalls.begin(), internalCalls.end());
+    for (WebCLAnalyser::CallExprSet::iterator i = calls.begin();
+         i != calls.end(); ++i) {
+        if (!transformer_.isWrappedCall(*i))
+            continue;
+        if (clang::FunctionDecl *helper = getEnclosingHelper((*i)->getLocStart()))
+            functions.insert(helper);
+    }
+
+    // Callers of functions that need the allocation structure must
+    // pass it on. Propagate the need bottom-up until nothing changes.
+    typedef std::vector< std::pair<clang::FunctionDecl*, clang::FunctionDecl*> > CallGraph;
+    CallGraph callGraph;
+    for (WebCLAnalyser::CallExprSet::iterator i = internalCalls.begin();
+         i != internalCalls.end(); ++i) {
+        if (clang::FunctionDecl *caller = getEnclosingHelper((*i)->getLocStart())) {
+            clang::FunctionDecl *callee = (*i)->getDirectCallee()->getCanonicalDecl();
+            callGraph.push_back(std::make_pair(caller, callee));
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (CallGraph::iterator i = callGraph.begin(); i != callGraph.end(); ++i) {
+            if (functions.count(i->second) && functions.insert(i->first).second)
+                changed = true;
+        }
+    }
+}
+
+clang::FunctionDecl *WebCLHelperFunctionHandler::getEnclosingHelper(
+    clang::SourceLocation location)
+{
+    WebCLAnalyser::FunctionDeclSet &helperFunctions = analyser_.getHelperFunctions();
+    for (WebCLAnalyser::FunctionDeclSet::iterator i = helperFunctions.begin();
+        i != helperFunctions.end(); ++i) {
+        clang::FunctionDecl *helper = *i;
+        if (helper->doesThisDeclarationHaveABody() && analyser_.isInside(location, helper))
+            return helper->getCanonicalDecl();
+    }
+    return NULL;
 }
 
 WebCLAddressSpaceHandler::WebCLAddressSpaceHandler(
@@ -109,6 +436,15 @@ WebCLAddressSpaceHandler::~WebCLAddressSpaceHandler()
 
 void WebCLAddressSpaceHandler::run(clang::ASTContext &context)
 {
+    AddressSpaceSet directlyIndexed;
+    WebCLOptions options(instance_);
+    if (options.isEnabled(WebCLOptions::clampIndices_)) {
+        findDirectlyIndexedArrays(context, true, directlyIndexed);
+    } else if (options.isEnabled(WebCLOptions::constantIndices_)) {
+        findDirectlyIndexedArrays(context, false, directlyIndexed);
+    }
+
+    const bool escapeAnalysis = options.isEnabled(WebCLOptions::escapeAnalysis_);
     WebCLAnalyser::VarDeclSet &privateVars = analyser_.getPrivateVariables();
     for(WebCLAnalyser::VarDeclSet::iterator i = privateVars.begin();
         i != privateVars.end(); ++i) {
@@ -121,7 +457,19 @@ void WebCLAddressSpaceHandler::run(clang::ASTContext &context)
             //       to optimize this, normalization pass adding zero initializers
             //       should be made.
             clang::VarDecl *decl = *i;
-            if (decl->getType()->isPointerType() ||
+            const bool isParameter = llvm::isa<clang::ParmVarDecl>(decl);
+            if (decl->hasInit() && directlyIndexed.count(decl)) {
+                DEBUG(
+                    std::cerr << "Skipping directly indexed: "
+                    << decl->getDeclName().getAsString() << "\n"; );
+            } else if (escapeAnalysis && analyser_.hasOnlySafeAddressReferences(decl) &&
+                       (decl->hasInit() || isParameter || !analyser_.isInsideForStmt(decl))) {
+                DEBUG(
+                    std::cerr << "Skipping safe address references: "
+                    << decl->getDeclName().getAsString() << "\n"; );
+                if (!decl->hasInit() && !isParameter)
+                    transformer_.addZeroInitializer(decl);
+            } else if (decl->getType()->isPointerType() ||
                 decl->getType()->isStructureType() ||
                 decl->getType()->isArrayType() ||
                 analyser_.hasAddressReferences(decl) ||
@@ -140,7 +488,8 @@ void WebCLAddressSpaceHandler::run(clang::ASTContext &context)
     WebCLAnalyser::VarDeclSet &constantVars = analyser_.getConstantVariables();
     for(WebCLAnalyser::VarDeclSet::iterator i = constantVars.begin();
         i != constantVars.end(); ++i) {
-            constants_.insert(*i);
+            if (!directlyIndexed.count(*i))
+                constants_.insert(*i);
     }
 
     WebCLAnalyser::VarDeclSet &localVars = analyser_.getLocalVariables();
@@ -149,10 +498,23 @@ void WebCLAddressSpaceHandler::run(clang::ASTContext &context)
             locals_.insert(*i);
     }
 
+    if (options.isEnabled(WebCLOptions::padLocals_)) {
+        const unsigned padded =
+            padLocalArrays(context, options.getValue(WebCLOptions::padLocals_, 0));
+        info("Padded %0 local arrays to a power of two number of elements.") << padded;
+    }
+
+    if (options.isEnabled(WebCLOptions::shareSlots_))
+        assignSharedSlots(context);
+
     // create address space types
     transformer_.createPrivateAddressSpaceTypedef(getPrivateAddressSpace());
     transformer_.createLocalAddressSpaceTypedef(getLocalAddressSpace());
     transformer_.createConstantAddressSpaceTypedef(getConstantAddressSpace());
+
+    info("Relocated variables take %0 bytes of private and %1 bytes of local memory.")
+        << static_cast<unsigned>(transformer_.getAddressSpaceSize(getPrivateAddressSpace()))
+        << static_cast<unsigned>(transformer_.getAddressSpaceSize(getLocalAddressSpace()));
 }
 
 bool WebCLAddressSpaceHandler::hasPrivateAddressSpace()
@@ -266,15 +628,221 @@ bool WebCLAddressSpaceHandler::isRelocated(clang::VarDecl *decl)
     }
 }
 
+void WebCLAddressSpaceHandler::findDirectlyIndexedArrays(
+    clang::ASTContext &context, bool clampedIndices, AddressSpaceSet &arrays)
+{
+    // count accesses that can't go out of bounds
+    std::map<clang::VarDecl*, unsigned> safeUses;
+    WebCLAnalyser::MemoryAccessMap &accesses = analyser_.getPointerAceesses();
+    for (WebCLAnalyser::MemoryAccessMap::iterator i = accesses.begin();
+         i != accesses.end(); ++i) {
+        clang::VarDecl *decl = analyser_.getIndexedArray(i->first);
+        if (!decl)
+            continue;
+        if (!clampedIndices && !analyser_.isConstantIndexInBounds(i->first))
+            continue;
+        // a[0][i] and a[0].b[i] would still need a relocated array
+        clang::QualType elementType =
+            context.getAsConstantArrayType(decl->getType())->getElementType();
+        if (elementType->isArithmeticType() || elementType->isVectorType())
+            ++safeUses[decl];
+    }
+
+    // compare them against all uses, e.g. sizeof(a) or p = a
+    std::map<clang::VarDecl*, unsigned> allUses;
+    WebCLAnalyser::DeclRefExprSet &varUses = analyser_.getVariableUses();
+    for (WebCLAnalyser::DeclRefExprSet::iterator i = varUses.begin();
+         i != varUses.end(); ++i) {
+        clang::VarDecl *decl = llvm::dyn_cast<clang::VarDecl>((*i)->getDecl());
+        if (decl && safeUses.count(decl))
+            ++allUses[decl];
+    }
+
+    for (std::map<clang::VarDecl*, unsigned>::iterator i = safeUses.begin();
+         i != safeUses.end(); ++i) {
+        clang::VarDecl *decl = i->first;
+        if ((allUses[decl] == i->second) && !analyser_.hasAddressReferences(decl))
+            arrays.insert(decl);
+    }
+}
+
+namespace {
+
+    /// Padding that is needed to round a local array up to a power
+    /// of two number of elements.
+    struct LocalArrayPadding
+    {
+        clang::VarDecl *decl;
+        unsigned long long paddedSize;
+        unsigned long long paddingBytes;
+    };
+
+    bool hasLessPadding(const LocalArrayPadding &lhs, const LocalArrayPadding &rhs)
+    {
+        return lhs.paddingBytes < rhs.paddingBytes;
+    }
+
+    /// Orders relocated variables by decreasing alignment and size so
+    /// that no padding is needed between structure fields. Variables
+    /// with equal alignment and size are kept in source order.
+    class FieldOrder
+    {
+    public:
+
+        explicit FieldOrder(clang::ASTContext &context)
+            : context_(context)
+        {
+        }
+
+        bool operator()(const clang::VarDecl *lhs, const clang::VarDecl *rhs) const
+        {
+            const clang::CharUnits lhsAlignment = context_.getTypeAlignInChars(lhs->getType());
+            const clang::CharUnits rhsAlignment = context_.getTypeAlignInChars(rhs->getType());
+            if (lhsAlignment != rhsAlignment)
+                return lhsAlignment > rhsAlignment;
+            const clang::CharUnits lhsSize = context_.getTypeSizeInChars(lhs->getType());
+            const clang::CharUnits rhsSize = context_.getTypeSizeInChars(rhs->getType());
+            if (lhsSize != rhsSize)
+                return lhsSize > rhsSize;
+            return context_.getSourceManager().isBeforeInTranslationUnit(
+                lhs->getLocation(), rhs->getLocation());
+        }
+
+    private:
+
+        clang::ASTContext &context_;
+    };
+}
+
+unsigned WebCLAddressSpaceHandler::padLocalArrays(clang::ASTContext &context, unsigned budget)
+{
+    AddressSpaceSet directlyIndexed;
+    findDirectlyIndexedArrays(context, true, directlyIndexed);
+
+    std::vector<LocalArrayPadding> paddings;
+    for (AddressSpaceSet::iterator i = locals_.begin(); i != locals_.end(); ++i) {
+        if (!directlyIndexed.count(*i))
+            continue;
+        const clang::ConstantArrayType *array =
+            context.getAsConstantArrayType((*i)->getType());
+        const unsigned long long size = array->getSize().getZExtValue();
+
+        LocalArrayPadding padding;
+        padding.decl = *i;
+        padding.paddedSize = 1;
+        while (padding.paddedSize < size)
+            padding.paddedSize <<= 1;
+        padding.paddingBytes = (padding.paddedSize - size) *
+            context.getTypeSizeInChars(array->getElementType()).getQuantity();
+        paddings.push_back(padding);
+    }
+    // arrays that already have a power of two size come first
+    std::stable_sort(paddings.begin(), paddings.end(), hasLessPadding);
+
+    unsigned long long used = 0;
+    unsigned padded = 0;
+    for (std::vector<LocalArrayPadding>::iterator i = paddings.begin();
+         i != paddings.end(); ++i) {
+        used += i->paddingBytes;
+        if (used > budget)
+            break;
+        transformer_.addArrayPadding(i->decl, i->paddedSize);
+        ++padded;
+    }
+    return padded;
+}
+
+void WebCLAddressSpaceHandler::assignSharedSlots(clang::ASTContext &context)
+{
+    // find calls between function definitions
+    typedef std::pair<const clang::FunctionDecl*, const clang::FunctionDecl*> Call;
+    std::vector<Call> calls;
+    std::vector<clang::FunctionDecl*> functions;
+    WebCLAnalyser::KernelList &kernels = analyser_.getKernelFunctions();
+    for (WebCLAnalyser::KernelList::iterator i = kernels.begin(); i != kernels.end(); ++i)
+        functions.push_back(i->decl);
+    WebCLAnalyser::FunctionDeclSet &helpers = analyser_.getHelperFunctions();
+    functions.insert(functions.end(), helpers.begin(), helpers.end());
+
+    WebCLAnalyser::CallExprSet &internalCalls = analyser_.getInternalCalls();
+    for (std::vector<clang::FunctionDecl*>::iterator i = functions.begin();
+         i != functions.end(); ++i) {
+        if (!(*i)->doesThisDeclarationHaveABody())
+            continue;
+        clang::ParentMap parents((*i)->getBody());
+        for (WebCLAnalyser::CallExprSet::iterator j = internalCalls.begin();
+             j != internalCalls.end(); ++j) {
+            if (parents.hasParent(*j)) {
+                calls.push_back(Call((*i)->getCanonicalDecl(),
+                                     (*j)->getDirectCallee()->getCanonicalDecl()));
+            }
+        }
+    }
+
+    // call depths, give up if they don't settle because of recursion
+    std::map<const clang::FunctionDecl*, unsigned> depths;
+    for (WebCLAnalyser::KernelList::iterator i = kernels.begin(); i != kernels.end(); ++i)
+        depths[i->decl->getCanonicalDecl()] = 0;
+    bool changed = true;
+    for (unsigned round = 0; changed && (round <= functions.size()); ++round) {
+        changed = false;
+        for (std::vector<Call>::iterator i = calls.begin(); i != calls.end(); ++i) {
+            if (!depths.count(i->first))
+                continue;
+            const unsigned depth = depths[i->first] + 1;
+            if (!depths.count(i->second) || (depths[i->second] < depth)) {
+                depths[i->second] = depth;
+                changed = true;
+            }
+        }
+    }
+    if (changed)
+        return;
+
+    unsigned long long unshared = 0;
+    std::map<unsigned, std::map<const clang::FunctionDecl*, unsigned long long> > slotSizes;
+    for (AddressSpaceSet::iterator i = privates_.begin(); i != privates_.end(); ++i) {
+        const clang::FunctionDecl *func =
+            llvm::dyn_cast_or_null<clang::FunctionDecl>((*i)->getParentFunctionOrMethod());
+        if (!func || !depths.count(func->getCanonicalDecl()))
+            continue;
+        const unsigned depth = depths[func->getCanonicalDecl()];
+        const unsigned long long size = context.getTypeSizeInChars((*i)->getType()).getQuantity();
+        transformer_.addSharedSlot(*i, depth, func->getNameAsString());
+        slotSizes[depth][func->getCanonicalDecl()] += size;
+        unshared += size;
+    }
+
+    unsigned long long shared = 0;
+    for (std::map<unsigned, std::map<const clang::FunctionDecl*, unsigned long long> >::iterator i =
+             slotSizes.begin(); i != slotSizes.end(); ++i) {
+        unsigned long long largest = 0;
+        for (std::map<const clang::FunctionDecl*, unsigned long long>::iterator j =
+                 i->second.begin(); j != i->second.end(); ++j) {
+            largest = std::max(largest, j->second);
+        }
+        shared += largest;
+    }
+    info("Shared slots reduce relocated private variables from %0 to %1 bytes.")
+        << static_cast<unsigned>(unshared) << static_cast<unsigned>(shared);
+
+    for (AddressSpaceSet::iterator i = locals_.begin(); i != locals_.end(); ++i) {
+        const clang::FunctionDecl *func =
+            llvm::dyn_cast_or_null<clang::FunctionDecl>((*i)->getParentFunctionOrMethod());
+        if (func)
+            transformer_.addSharedSlot(*i, 0, func->getNameAsString());
+    }
+}
+
 AddressSpaceInfo& WebCLAddressSpaceHandler::getOrCreateAddressSpaceInfo(AddressSpaceSet *declarations)
 {
-    // IMPROVEMENT: To optimize padding bytes to minimum
-    //              add sorting declarations according to their size
     if (organizedAddressSpaces_.count(declarations) == 0) {
+        AddressSpaceInfo &organized = organizedAddressSpaces_[declarations];
         for (AddressSpaceSet::iterator declIter = declarations->begin();
             declIter != declarations->end(); ++declIter) {
-                organizedAddressSpaces_[declarations].push_back(*declIter);
+                organized.push_back(*declIter);
         }
+        std::sort(organized.begin(), organized.end(), FieldOrder(instance_.getASTContext()));
     }
     return organizedAddressSpaces_[declarations];
 }
@@ -289,13 +857,398 @@ void WebCLAddressSpaceHandler::removeRelocatedVariables(AddressSpaceSet &variabl
     }
 }
 
+namespace {
+    typedef std::set<clang::VarDecl*> OperandSet;
+
+    /// \return Whether the expression itself assigns to,
+    /// increments or decrements any of the operands.
+    bool assignsOperand(clang::Stmt *stmt, const OperandSet &operands)
+    {
+        clang::Expr *modified = NULL;
+        if (clang::BinaryOperator *binary = llvm::dyn_cast<clang::BinaryOperator>(stmt)) {
+            if (binary->isAssignmentOp())
+                modified = binary->getLHS();
+        } else if (clang::UnaryOperator *unary = llvm::dyn_cast<clang::UnaryOperator>(stmt)) {
+            if (unary->isIncrementDecrementOp())
+                modified = unary->getSubExpr();
+        }
+
+        if (!modified)
+            return false;
+
+        clang::DeclRefExpr *ref =
+            llvm::dyn_cast<clang::DeclRefExpr>(modified->IgnoreParenImpCasts());
+        clang::VarDecl *var = ref ? llvm::dyn_cast<clang::VarDecl>(ref->getDecl()) : NULL;
+        return var && operands.count(var);
+    }
+
+    /// \return Whether any of the operands is assigned to anywhere
+    /// within the statement.
+    bool mayAssignOperands(clang::Stmt *stmt, const OperandSet &operands)
+    {
+        if (!stmt)
+            return false;
+
+        if (assignsOperand(stmt, operands))
+            return true;
+
+        for (clang::Stmt::child_iterator i = stmt->child_begin(); i != stmt->child_end(); ++i) {
+            if (mayAssignOperands(*i, operands))
+                return true;
+        }
+        return false;
+    }
+
+    /// \return Whether a statement may leave the block or jump within
+    /// it, so that statements after it aren't necessarily executed.
+    bool mayJump(clang::Stmt *stmt)
+    {
+        if (!stmt)
+            return false;
+
+        if (llvm::isa<clang::ReturnStmt>(stmt) || llvm::isa<clang::GotoStmt>(stmt) ||
+            llvm::isa<clang::IndirectGotoStmt>(stmt) ||
+            llvm::isa<clang::BreakStmt>(stmt) || llvm::isa<clang::ContinueStmt>(stmt)) {
+            return true;
+        }
+
+        for (clang::Stmt::child_iterator i = stmt->child_begin(); i != stmt->child_end(); ++i) {
+            if (mayJump(*i))
+                return true;
+        }
+        return false;
+    }
+
+    /// \return Dimension given to a call of the named work-item
+    /// function, or -1 if the expression isn't such a call. Constant
+    /// variables that are initialized with the call are looked
+    /// through as long as they are wide enough to hold any local ID.
+    int getWorkItemDimension(clang::ASTContext &context, clang::Expr *expr,
+                             const std::string &function)
+    {
+        expr = expr->IgnoreParenImpCasts();
+
+        if (clang::DeclRefExpr *ref = llvm::dyn_cast<clang::DeclRefExpr>(expr)) {
+            clang::VarDecl *var = llvm::dyn_cast<clang::VarDecl>(ref->getDecl());
+            if (!var || !var->getType().isConstQualified() || !var->hasInit() ||
+                !var->getType()->isIntegerType() || (context.getTypeSize(var->getType()) < 32))
+                return -1;
+            return getWorkItemDimension(context, var->getInit(), function);
+        }
+
+        clang::CallExpr *call = llvm::dyn_cast<clang::CallExpr>(expr);
+        clang::FunctionDecl *callee = call ? call->getDirectCallee() : NULL;
+        if (!callee || (callee->getNameAsString() != function) || (call->getNumArgs() != 1))
+            return -1;
+
+        llvm::APSInt dimension;
+        if (!call->getArg(0)->EvaluateAsInt(dimension, context) ||
+            (dimension.getLimitedValue() > 2))
+            return -1;
+        return dimension.getLimitedValue();
+    }
+
+    /// \return Whether the statement is a barrier that orders local
+    /// memory accesses.
+    bool isLocalBarrier(clang::ASTContext &context, clang::Stmt *stmt)
+    {
+        clang::CallExpr *call = llvm::dyn_cast<clang::CallExpr>(stmt);
+        clang::FunctionDecl *callee = call ? call->getDirectCallee() : NULL;
+        if (!callee || (callee->getNameAsString() != "barrier") || (call->getNumArgs() != 1))
+            return false;
+
+        // CLK_LOCAL_MEM_FENCE
+        llvm::APSInt flags;
+        return call->getArg(0)->EvaluateAsInt(flags, context) && (flags.getLimitedValue() & 0x1);
+    }
+
+    /// \return Local array variable referenced directly by the base
+    /// of an array subscript, or NULL.
+    clang::DeclRefExpr *getLocalArrayReference(clang::Expr *base)
+    {
+        clang::DeclRefExpr *ref = llvm::dyn_cast<clang::DeclRefExpr>(base->IgnoreParenImpCasts());
+        clang::VarDecl *var = ref ? llvm::dyn_cast<clang::VarDecl>(ref->getDecl()) : NULL;
+        if (!var || (var->getType().getAddressSpace() != clang::LangAS::opencl_local) ||
+            !var->getType()->isConstantArrayType())
+            return NULL;
+        return ref;
+    }
+
+    /// \return Whether every byte of a variable of the given type
+    /// belongs to some scalar or vector element, so that assigning
+    /// all elements leaves no padding unwritten.
+    bool hasNoPadding(clang::ASTContext &context, clang::QualType type)
+    {
+        type = context.getBaseElementType(type);
+        if (const clang::VectorType *vector = type->getAs<clang::VectorType>())
+            return vector->getNumElements() != 3;
+        return type->isScalarType();
+    }
+
+    /// \return Reference to a local array whose every element is
+    /// assigned when all work-items of a work-group execute the
+    /// statement, or NULL. The statement must either index the array
+    /// with distinct local IDs whose required work-group sizes cover
+    /// the array dimensions, e.g. "tile[get_local_id(1)][get_local_id(0)] = ...",
+    /// or be a loop that strides a one dimensional array by the
+    /// work-group size, e.g.
+    /// "for (int i = get_local_id(0); i < N; i += get_local_size(0)) array[i] = ...".
+    /// Elements with padding, such as structures or three component
+    /// vectors, don't count as written.
+    clang::DeclRefExpr *getFullyWrittenArray(clang::ASTContext &context, clang::Stmt *stmt,
+                                             const unsigned *groupSize)
+    {
+        if (clang::ForStmt *loop = llvm::dyn_cast<clang::ForStmt>(stmt)) {
+            clang::DeclStmt *init = llvm::dyn_cast_or_null<clang::DeclStmt>(loop->getInit());
+            clang::VarDecl *counter = (init && init->isSingleDecl()) ?
+                llvm::dyn_cast<clang::VarDecl>(init->getSingleDecl()) : NULL;
+            if (!counter || !counter->hasInit() || !counter->getType()->isIntegerType() ||
+                (context.getTypeSize(counter->getType()) < 32))
+                return NULL;
+
+            const int dimension = getWorkItemDimension(context, counter->getInit(), "get_local_id");
+            clang::BinaryOperator *cond =
+                llvm::dyn_cast_or_null<clang::BinaryOperator>(loop->getCond());
+            clang::CompoundAssignOperator *inc =
+                llvm::dyn_cast_or_null<clang::CompoundAssignOperator>(loop->getInc());
+            if ((dimension < 0) || !cond || (cond->getOpcode() != clang::BO_LT) ||
+                !inc || (inc->getOpcode() != clang::BO_AddAssign))
+                return NULL;
+
+            clang::DeclRefExpr *condRef =
+                llvm::dyn_cast<clang::DeclRefExpr>(cond->getLHS()->IgnoreParenImpCasts());
+            clang::DeclRefExpr *incRef =
+                llvm::dyn_cast<clang::DeclRefExpr>(inc->getLHS()->IgnoreParenImpCasts());
+            llvm::APSInt bound;
+            if (!condRef || (condRef->getDecl() != counter) ||
+                !incRef || (incRef->getDecl() != counter) ||
+                (getWorkItemDimension(context, inc->getRHS(), "get_local_size") != dimension) ||
+                !cond->getRHS()->EvaluateAsInt(bound, context) || bound.isNegative())
+                return NULL;
+
+            clang::Stmt *body = loop->getBody();
+            if (clang::CompoundStmt *block = llvm::dyn_cast<clang::CompoundStmt>(body)) {
+                if (block->size() != 1)
+                    return NULL;
+                body = block->body_back();
+            }
+
+            clang::BinaryOperator *assignment = llvm::dyn_cast<clang::BinaryOperator>(body);
+            if (!assignment || (assignment->getOpcode() != clang::BO_Assign))
+                return NULL;
+            OperandSet operands;
+            operands.insert(counter);
+            if (mayAssignOperands(assignment->getRHS(), operands))
+                return NULL;
+
+            clang::ArraySubscriptExpr *subscript =
+                llvm::dyn_cast<clang::ArraySubscriptExpr>(assignment->getLHS()->IgnoreParens());
+            clang::DeclRefExpr *index = subscript ?
+                llvm::dyn_cast<clang::DeclRefExpr>(subscript->getIdx()->IgnoreParenImpCasts()) : NULL;
+            clang::DeclRefExpr *array = subscript ? getLocalArrayReference(subscript->getBase()) : NULL;
+            if (!index || (index->getDecl() != counter) || !array)
+                return NULL;
+
+            const clang::ConstantArrayType *type =
+                context.getAsConstantArrayType(array->getType());
+            if (!type || type->getElementType()->isArrayType() ||
+                !hasNoPadding(context, type->getElementType()) ||
+                (bound.getLimitedValue() < type->getSize().getLimitedValue()))
+                return NULL;
+            return array;
+        }
+
+        clang::BinaryOperator *assignment = llvm::dyn_cast<clang::BinaryOperator>(stmt);
+        if (!assignment || (assignment->getOpcode() != clang::BO_Assign))
+            return NULL;
+
+        // Collect indices from the outermost array dimension to the
+        // innermost one.
+        std::vector<clang::Expr*> indices;
+        clang::Expr *base = assignment->getLHS()->IgnoreParens();
+        while (clang::ArraySubscriptExpr *subscript =
+               llvm::dyn_cast<clang::ArraySubscriptExpr>(base)) {
+            indices.insert(indices.begin(), subscript->getIdx());
+            base = subscript->getBase()->IgnoreParenImpCasts();
+        }
+
+        clang::DeclRefExpr *array = indices.empty() ? NULL : getLocalArrayReference(base);
+        if (!array)
+            return NULL;
+
+        bool usedDimensions[3] = { false, false, false };
+        clang::QualType type = array->getType();
+        for (std::vector<clang::Expr*>::iterator i = indices.begin(); i != indices.end(); ++i) {
+            const clang::ConstantArrayType *arrayType = context.getAsConstantArrayType(type);
+            const int dimension = getWorkItemDimension(context, *i, "get_local_id");
+            if (!arrayType || (dimension < 0) || usedDimensions[dimension] ||
+                (groupSize[dimension] < arrayType->getSize().getLimitedValue()))
+                return NULL;
+            usedDimensions[dimension] = true;
+            type = arrayType->getElementType();
+        }
+        return (type->isArrayType() || !hasNoPadding(context, type)) ? NULL : array;
+    }
+
+    /// Collects references to local memory, i.e. to local variables
+    /// and to pointers that point to local memory.
+    void collectLocalReferences(clang::Stmt *stmt, std::vector<clang::DeclRefExpr*> &references)
+    {
+        if (!stmt)
+            return;
+
+        if (clang::DeclRefExpr *ref = llvm::dyn_cast<clang::DeclRefExpr>(stmt)) {
+            clang::QualType type = ref->getType();
+            if ((type.getAddressSpace() == clang::LangAS::opencl_local) ||
+                (type->isPointerType() &&
+                 (type->getPointeeType().getAddressSpace() == clang::LangAS::opencl_local))) {
+                references.push_back(ref);
+            }
+        }
+
+        for (clang::Stmt::child_iterator i = stmt->child_begin(); i != stmt->child_end(); ++i)
+            collectLocalReferences(*i, references);
+    }
+
+    /// Collects references that may access private memory, i.e.
+    /// references to relocated variables and to pointers that point
+    /// to private memory.
+    void collectPrivateReferences(clang::Stmt *stmt, const OperandSet &relocated,
+                                  std::vector<clang::DeclRefExpr*> &references)
+    {
+        if (!stmt)
+            return;
+
+        if (clang::DeclRefExpr *ref = llvm::dyn_cast<clang::DeclRefExpr>(stmt)) {
+            clang::VarDecl *var = llvm::dyn_cast<clang::VarDecl>(ref->getDecl());
+            clang::QualType type = ref->getType();
+            if ((var && relocated.count(var)) ||
+                (type->isPointerType() && !type->getPointeeType().getAddressSpace())) {
+                references.push_back(ref);
+            }
+        }
+
+        for (clang::Stmt::child_iterator i = stmt->child_begin(); i != stmt->child_end(); ++i)
+            collectPrivateReferences(*i, relocated, references);
+    }
+
+    /// \return Whether the statement calls a function defined in the
+    /// program. Such functions may access private memory through
+    /// their own relocated variables.
+    bool callsDefinedFunction(clang::Stmt *stmt)
+    {
+        if (!stmt)
+            return false;
+
+        if (clang::CallExpr *call = llvm::dyn_cast<clang::CallExpr>(stmt)) {
+            clang::FunctionDecl *callee = call->getDirectCallee();
+            if (!callee || callee->hasBody())
+                return true;
+        }
+
+        for (clang::Stmt::child_iterator i = stmt->child_begin(); i != stmt->child_end(); ++i) {
+            if (callsDefinedFunction(*i))
+                return true;
+        }
+        return false;
+    }
+
+    /// \return Whether the expression refers directly to the variable.
+    bool refersTo(clang::Expr *expr, clang::VarDecl *var)
+    {
+        clang::DeclRefExpr *ref = llvm::dyn_cast_or_null<clang::DeclRefExpr>(
+            expr ? expr->IgnoreParenImpCasts() : NULL);
+        return ref && (ref->getDecl() == var);
+    }
+
+    /// \return Whether the expression increments the variable by one.
+    bool incrementsByOne(clang::ASTContext &context, clang::Expr *expr, clang::VarDecl *var)
+    {
+        if (clang::UnaryOperator *unary = llvm::dyn_cast_or_null<clang::UnaryOperator>(expr))
+            return unary->isIncrementOp() && refersTo(unary->getSubExpr(), var);
+
+        clang::CompoundAssignOperator *inc =
+            llvm::dyn_cast_or_null<clang::CompoundAssignOperator>(expr);
+        llvm::APSInt step;
+        return inc && (inc->getOpcode() == clang::BO_AddAssign) && refersTo(inc->getLHS(), var) &&
+            inc->getRHS()->EvaluateAsInt(step, context) && (step.getLimitedValue() == 1);
+    }
+
+    /// \return Reference to a relocated private array whose every
+    /// element is assigned by a nest of loops that count from zero
+    /// up to the array dimensions, e.g.
+    /// "for (int i = 0; i < N; ++i) for (int j = 0; j < M; ++j) array[i][j] = ...",
+    /// or NULL.
+    clang::DeclRefExpr *getLoopAssignedArray(clang::ASTContext &context, clang::ForStmt *loop,
+                                             const OperandSet &relocated)
+    {
+        std::vector<clang::VarDecl*> counters;
+        std::vector<uint64_t> bounds;
+        clang::Stmt *stmt = loop;
+        while (clang::ForStmt *current = llvm::dyn_cast<clang::ForStmt>(stmt)) {
+            clang::DeclStmt *init = llvm::dyn_cast_or_null<clang::DeclStmt>(current->getInit());
+            clang::VarDecl *counter = (init && init->isSingleDecl()) ?
+                llvm::dyn_cast<clang::VarDecl>(init->getSingleDecl()) : NULL;
+            clang::BinaryOperator *cond =
+                llvm::dyn_cast_or_null<clang::BinaryOperator>(current->getCond());
+            llvm::APSInt start;
+            llvm::APSInt bound;
+            if (!counter || !counter->hasInit() || !counter->getType()->isIntegerType() ||
+                !counter->getInit()->EvaluateAsInt(start, context) || (start.getLimitedValue() != 0) ||
+                !cond || (cond->getOpcode() != clang::BO_LT) || !refersTo(cond->getLHS(), counter) ||
+                !cond->getRHS()->EvaluateAsInt(bound, context) || bound.isNegative() ||
+                !incrementsByOne(context, current->getInc(), counter))
+                return NULL;
+
+            counters.push_back(counter);
+            bounds.push_back(bound.getLimitedValue());
+
+            stmt = current->getBody();
+            if (clang::CompoundStmt *block = llvm::dyn_cast<clang::CompoundStmt>(stmt)) {
+                if (block->size() != 1)
+                    return NULL;
+                stmt = block->body_back();
+            }
+        }
+
+        clang::BinaryOperator *assignment = llvm::dyn_cast<clang::BinaryOperator>(stmt);
+        const OperandSet operands(counters.begin(), counters.end());
+        if (!assignment || (assignment->getOpcode() != clang::BO_Assign) ||
+            mayAssignOperands(assignment->getRHS(), operands))
+            return NULL;
+
+        std::vector<clang::Expr*> indices;
+        clang::Expr *base = assignment->getLHS()->IgnoreParens();
+        while (clang::ArraySubscriptExpr *subscript =
+               llvm::dyn_cast<clang::ArraySubscriptExpr>(base)) {
+            indices.insert(indices.begin(), subscript->getIdx());
+            base = subscript->getBase()->IgnoreParenImpCasts();
+        }
+
+        clang::DeclRefExpr *array = llvm::dyn_cast<clang::DeclRefExpr>(base);
+        clang::VarDecl *var = array ? llvm::dyn_cast<clang::VarDecl>(array->getDecl()) : NULL;
+        if (!var || !relocated.count(var) || (indices.size() != counters.size()))
+            return NULL;
+
+        clang::QualType type = var->getType();
+        for (unsigned i = 0; i < indices.size(); ++i) {
+            const clang::ConstantArrayType *arrayType = context.getAsConstantArrayType(type);
+            if (!arrayType || !refersTo(indices[i], counters[i]) ||
+                (bounds[i] < arrayType->getSize().getLimitedValue()))
+                return NULL;
+            type = arrayType->getElementType();
+        }
+        return (type->isArrayType() || !hasNoPadding(context, type)) ? NULL : array;
+    }
+}
+
 WebCLKernelHandler::WebCLKernelHandler(
     clang::CompilerInstance &instance,
     WebCLAnalyser &analyser, WebCLTransformer &transformer,
     WebCLAddressSpaceHandler &addressSpaceHandler)
     : WebCLPass(instance, analyser, transformer)
     , addressSpaceHandler_(addressSpaceHandler)
-    , helperFunctionHandler_(instance, analyser, transformer)
+    , helperFunctionHandler_(instance, analyser, transformer, addressSpaceHandler)
     , globalLimits_(clang::LangAS::opencl_global)
     , constantLimits_(clang::LangAS::opencl_constant)
     , localLimits_(clang::LangAS::opencl_local)
@@ -319,13 +1272,25 @@ void WebCLKernelHandler::run(clang::ASTContext &context)
     WebCLAnalyser::KernelList &kernels = analyser_.getKernelFunctions();
     for (WebCLAnalyser::KernelList::iterator i = kernels.begin();
         i != kernels.end(); ++i) {
+            bool hasConstantRegion = false;
             for (std::vector<WebCLAnalyser::KernelArgInfo>::const_iterator j = i->args.begin();
                 j != i->args.end(); ++j) {
                     const WebCLAnalyser::KernelArgInfo &parm = *j;
                     if (parm.pointerKind != WebCLTypes::NOT_POINTER &&
                         parm.pointerKind != WebCLTypes::IMAGE_HANDLE) {
 
-                        transformer_.addSizeParameter(parm.decl);
+                        // Memory objects in the constant region are
+                        // checked against the limits of the region.
+                        if (parm.inConstantRegion) {
+                            hasConstantRegion = true;
+                            continue;
+                        }
+
+                        if (parm.isPadded) {
+                            transformer_.addMaskParameter(parm.decl);
+                        } else {
+                            transformer_.addSizeParameter(parm.decl);
+                        }
 
                         DEBUG(
                             std::cerr << "Adding dynamic limits from kernel:"
@@ -355,6 +1320,11 @@ void WebCLKernelHandler::run(clang::ASTContext &context)
                         }
                     }
             }
+
+            if (hasConstantRegion) {
+                transformer_.addConstantRegionParameters(i->decl);
+                constantLimits_.setRegionLimits(true);
+            }
     }
 
     // Add typedefs for each limit structure. These are required if
@@ -373,6 +1343,9 @@ void WebCLKernelHandler::run(clang::ASTContext &context)
 
     // now that we have all the data about the limit structures, we can actually
     // create the initialization code for each kernel
+    WebCLOptions options(instance_);
+    const bool skipWrittenLocals = options.isEnabled(WebCLOptions::skipWrittenLocals_);
+    const bool lazyPrivates = options.isEnabled(WebCLOptions::lazyPrivates_);
     for (WebCLAnalyser::KernelList::iterator i = kernels.begin();
         i != kernels.end(); ++i) {
 
@@ -392,9 +1365,12 @@ void WebCLKernelHandler::run(clang::ASTContext &context)
             // also static initializator and prevent need for separate private
             // area zeroing...
             if (hasProgramAllocations()) {
+                AddressSpaceInfo writtenPrivates;
+                if (lazyPrivates)
+                    findWrittenPrivates(context, func, writtenPrivates);
                 transformer_.createProgramAllocationsAllocation(
                     func, globalLimits_, constantLimits_, localLimits_,
-                    addressSpaceHandler_.getPrivateAddressSpace());
+                    addressSpaceHandler_.getPrivateAddressSpace(), writtenPrivates);
             }
 
             // Initialize null pointers for global and private addres spaces
@@ -404,7 +1380,10 @@ void WebCLKernelHandler::run(clang::ASTContext &context)
             }
 
             // inject code that does zero initializing for all local memory ranges
-            transformer_.createLocalAreaZeroing(func, localLimits_);
+            AddressSpaceInfo writtenArrays;
+            const bool synchronized = skipWrittenLocals &&
+                findWrittenLocalArrays(context, func, writtenArrays);
+            transformer_.createLocalAreaZeroing(func, localLimits_, writtenArrays, !synchronized);
     }
 
     // Fixes all the function signatures and calls of internal helper functions
@@ -491,6 +1470,177 @@ void WebCLKernelHandler::createDeclarationLimits(clang::VarDecl *decl)
     // FUTURE: find out if we can trace single limits for this declaration...
 }
 
+void WebCLKernelHandler::findWrittenPrivates(
+    clang::ASTContext &context, clang::FunctionDecl *kernel, AddressSpaceInfo &privates)
+{
+    clang::CompoundStmt *body = llvm::dyn_cast_or_null<clang::CompoundStmt>(kernel->getBody());
+    if (!body)
+        return;
+
+    AddressSpaceInfo &as = addressSpaceHandler_.getPrivateAddressSpace();
+    const OperandSet relocated(as.begin(), as.end());
+
+    // Relocated variables that are completely written and elements
+    // of one dimensional arrays that have been written so far.
+    OperandSet written;
+    std::map< clang::VarDecl*, std::set<uint64_t> > writtenElements;
+
+    // Private memory can't be read until the first statement that
+    // may access it through a pointer or an unwritten variable.
+    for (clang::CompoundStmt::body_iterator i = body->body_begin();
+         i != body->body_end(); ++i) {
+        clang::Stmt *stmt = *i;
+        if (mayJump(stmt) || llvm::isa<clang::LabelStmt>(stmt) || callsDefinedFunction(stmt))
+            break;
+
+        std::vector<clang::DeclRefExpr*> references;
+        collectPrivateReferences(stmt, relocated, references);
+
+        if (clang::DeclStmt *declStmt = llvm::dyn_cast<clang::DeclStmt>(stmt)) {
+            if (!references.empty())
+                break;
+            // Initializers are copied to relocated variables right
+            // after the declarations.
+            for (clang::DeclStmt::decl_iterator j = declStmt->decl_begin();
+                 j != declStmt->decl_end(); ++j) {
+                clang::VarDecl *var = llvm::dyn_cast<clang::VarDecl>(*j);
+                if (!var || !relocated.count(var) || !var->hasInit() ||
+                    !hasNoPadding(context, var->getType()))
+                    continue;
+                const clang::ConstantArrayType *arrayType =
+                    context.getAsConstantArrayType(var->getType());
+                if (!arrayType || !arrayType->getElementType()->isArrayType())
+                    written.insert(var);
+            }
+            continue;
+        }
+
+        if (references.empty())
+            continue;
+
+        clang::DeclRefExpr *target = NULL;
+        clang::BinaryOperator *assignment = llvm::dyn_cast<clang::BinaryOperator>(stmt);
+        if (clang::ForStmt *loop = llvm::dyn_cast<clang::ForStmt>(stmt)) {
+            target = getLoopAssignedArray(context, loop, relocated);
+        } else if (assignment && (assignment->getOpcode() == clang::BO_Assign)) {
+            clang::Expr *lhs = assignment->getLHS()->IgnoreParens();
+            clang::ArraySubscriptExpr *subscript = llvm::dyn_cast<clang::ArraySubscriptExpr>(lhs);
+            target = llvm::dyn_cast<clang::DeclRefExpr>(
+                subscript ? subscript->getBase()->IgnoreParenImpCasts() : lhs);
+        }
+
+        clang::VarDecl *var = target ? llvm::dyn_cast<clang::VarDecl>(target->getDecl()) : NULL;
+        for (std::vector<clang::DeclRefExpr*>::iterator j = references.begin();
+             j != references.end(); ++j) {
+            if (*j != target)
+                var = NULL;
+        }
+        if (!var || !relocated.count(var) || !hasNoPadding(context, var->getType()))
+            break;
+
+        if (llvm::isa<clang::ForStmt>(stmt)) {
+            written.insert(var);
+            continue;
+        }
+
+        const clang::ConstantArrayType *arrayType =
+            context.getAsConstantArrayType(var->getType());
+        clang::ArraySubscriptExpr *subscript =
+            llvm::dyn_cast<clang::ArraySubscriptExpr>(assignment->getLHS()->IgnoreParens());
+        if (!subscript) {
+            if (arrayType)
+                break;
+            written.insert(var);
+            continue;
+        }
+
+        llvm::APSInt index;
+        if (!arrayType || arrayType->getElementType()->isArrayType() ||
+            !subscript->getIdx()->EvaluateAsInt(index, context) || index.isNegative() ||
+            (index.getLimitedValue() >= arrayType->getSize().getLimitedValue()))
+            break;
+
+        std::set<uint64_t> &elements = writtenElements[var];
+        elements.insert(index.getLimitedValue());
+        if (elements.size() == arrayType->getSize().getLimitedValue())
+            written.insert(var);
+    }
+
+    for (AddressSpaceInfo::iterator i = as.begin(); i != as.end(); ++i) {
+        clang::VarDecl *decl = *i;
+        if (written.count(decl)) {
+            info(decl->getLocStart(),
+                 "Private variable is written before it can be read. "
+                 "Skipping its zero initialization.");
+            privates.push_back(decl);
+        }
+    }
+}
+
+bool WebCLKernelHandler::findWrittenLocalArrays(
+    clang::ASTContext &context, clang::FunctionDecl *kernel, AddressSpaceInfo &arrays)
+{
+    clang::CompoundStmt *body = llvm::dyn_cast_or_null<clang::CompoundStmt>(kernel->getBody());
+    if (!body)
+        return false;
+
+    // Without a required work-group size, arrays can only be
+    // written with loops that stride by the work-group size.
+    unsigned groupSize[3] = { 0, 0, 0 };
+    if (clang::ReqdWorkGroupSizeAttr *attr = kernel->getAttr<clang::ReqdWorkGroupSizeAttr>()) {
+        groupSize[0] = attr->getXDim();
+        groupSize[1] = attr->getYDim();
+        groupSize[2] = attr->getZDim();
+    }
+
+    std::set<clang::DeclRefExpr*> writes;
+    std::set<clang::VarDecl*> written;
+    std::vector<clang::DeclRefExpr*> references;
+    for (clang::CompoundStmt::body_iterator i = body->body_begin();
+         i != body->body_end(); ++i) {
+        clang::Stmt *stmt = *i;
+
+        if (isLocalBarrier(context, stmt)) {
+            for (std::vector<clang::DeclRefExpr*>::iterator j = references.begin();
+                 j != references.end(); ++j) {
+                if (!writes.count(*j))
+                    return false;
+            }
+
+            bool synchronized = true;
+            AddressSpaceInfo &locals = addressSpaceHandler_.getLocalAddressSpace();
+            for (AddressSpaceInfo::iterator j = locals.begin(); j != locals.end(); ++j) {
+                clang::VarDecl *decl = *j;
+                if (!written.count(decl))
+                    continue;
+                // Padding isn't written, so the array is still zeroed
+                // and the zeroing must complete before the writes.
+                if (transformer_.getPaddedArraySize(decl)) {
+                    synchronized = false;
+                    continue;
+                }
+                info(decl->getLocStart(),
+                     "Every work-item writes its part of the local array before the "
+                     "first barrier. Skipping zeroing of the array.");
+                arrays.push_back(decl);
+            }
+            return synchronized;
+        }
+
+        // All work-items must execute the writes.
+        if (mayJump(stmt) || llvm::isa<clang::LabelStmt>(stmt))
+            return false;
+
+        if (clang::DeclRefExpr *array = getFullyWrittenArray(context, stmt, groupSize)) {
+            writes.insert(array);
+            written.insert(llvm::cast<clang::VarDecl>(array->getDecl()));
+        }
+        collectLocalReferences(stmt, references);
+    }
+
+    return false;
+}
+
 WebCLMemoryAccessHandler::WebCLMemoryAccessHandler(
     clang::CompilerInstance &instance,
     WebCLAnalyser &analyser, WebCLTransformer &transformer,
@@ -504,6 +1654,628 @@ WebCLMemoryAccessHandler::~WebCLMemoryAccessHandler()
 {
 }
 
+namespace {
+    /// Orders statements by their source locations.
+    class SourceOrder
+    {
+    public:
+        SourceOrder(clang::SourceManager &manager)
+            : manager_(manager)
+        {
+        }
+
+        bool operator()(const clang::Stmt *lhs, const clang::Stmt *rhs) const
+        {
+            return manager_.isBeforeInTranslationUnit(lhs->getLocStart(), rhs->getLocStart());
+        }
+
+        bool operator()(const clang::Decl *lhs, const clang::Decl *rhs) const
+        {
+            return manager_.isBeforeInTranslationUnit(lhs->getLocStart(), rhs->getLocStart());
+        }
+
+    private:
+        clang::SourceManager &manager_;
+    };
+
+    /// Writes a key that identifies the value of an address
+    /// operand. Variables the value depends on are added to operands.
+    ///
+    /// \return False if the operand has side effects or if its value
+    /// may change without an assignment in the function.
+    bool writeOperandKey(WebCLAnalyser &analyser, clang::Expr *expr,
+                         std::ostream &key, OperandSet &operands)
+    {
+        expr = expr->IgnoreParens();
+
+        if (clang::CastExpr *cast = llvm::dyn_cast<clang::CastExpr>(expr)) {
+            key << "(" << cast->getType().getAsString() << ")";
+            return writeOperandKey(analyser, cast->getSubExpr(), key, operands);
+        }
+
+        if (clang::IntegerLiteral *literal = llvm::dyn_cast<clang::IntegerLiteral>(expr)) {
+            key << literal->getValue().toString(10, literal->getType()->isSignedIntegerType());
+            return true;
+        }
+
+        if (clang::CharacterLiteral *literal = llvm::dyn_cast<clang::CharacterLiteral>(expr)) {
+            key << literal->getValue();
+            return true;
+        }
+
+        if (clang::DeclRefExpr *ref = llvm::dyn_cast<clang::DeclRefExpr>(expr)) {
+            if (llvm::isa<clang::EnumConstantDecl>(ref->getDecl())) {
+                key << ref->getDecl()->getNameAsString();
+                return true;
+            }
+
+            clang::VarDecl *var = llvm::dyn_cast<clang::VarDecl>(ref->getDecl());
+            if (!var || var->getType().isVolatileQualified() || analyser.hasAddressReferences(var))
+                return false;
+            // Arrays always refer to the same memory. Other variables
+            // must be private, because otherwise other work items
+            // could modify them.
+            if (!var->getType()->isArrayType() &&
+                (!var->hasLocalStorage() || var->getType().getAddressSpace()))
+                return false;
+
+            key << "v" << static_cast<const void*>(var);
+            operands.insert(var);
+            return true;
+        }
+
+        if (clang::BinaryOperator *binary = llvm::dyn_cast<clang::BinaryOperator>(expr)) {
+            if (binary->isAssignmentOp() || (binary->getOpcode() == clang::BO_Comma))
+                return false;
+
+            key << "(";
+            if (!writeOperandKey(analyser, binary->getLHS(), key, operands))
+                return false;
+            key << binary->getOpcodeStr().str();
+            if (!writeOperandKey(analyser, binary->getRHS(), key, operands))
+                return false;
+            key << ")";
+            return true;
+        }
+
+        if (clang::UnaryOperator *unary = llvm::dyn_cast<clang::UnaryOperator>(expr)) {
+            switch (unary->getOpcode()) {
+            case clang::UO_Plus:
+            case clang::UO_Minus:
+            case clang::UO_Not:
+            case clang::UO_LNot:
+                key << clang::UnaryOperator::getOpcodeStr(unary->getOpcode()).str();
+                return writeOperandKey(analyser, unary->getSubExpr(), key, operands);
+            default:
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    /// \return Whether the child is always evaluated when the parent
+    /// is evaluated.
+    bool isEvaluatedWithParent(clang::Stmt *parent, clang::Stmt *child)
+    {
+        if (clang::ConditionalOperator *conditional =
+            llvm::dyn_cast<clang::ConditionalOperator>(parent)) {
+            return child == conditional->getCond();
+        }
+        if (clang::BinaryOperator *binary = llvm::dyn_cast<clang::BinaryOperator>(parent)) {
+            return !binary->isLogicalOp() || (child == binary->getLHS());
+        }
+        if (llvm::isa<clang::BinaryConditionalOperator>(parent) ||
+            llvm::isa<clang::UnaryExprOrTypeTraitExpr>(parent)) {
+            return false;
+        }
+        return llvm::isa<clang::Expr>(parent) || llvm::isa<clang::DeclStmt>(parent);
+    }
+
+    /// \return Whether the statement may modify any of the
+    /// operands. Labels are also considered modifying, because they
+    /// allow jumping into the middle of a block.
+    bool mayChangeOperands(clang::Stmt *stmt, const OperandSet &operands)
+    {
+        if (!stmt)
+            return false;
+
+        if (llvm::isa<clang::LabelStmt>(stmt) || llvm::isa<clang::SwitchCase>(stmt))
+            return true;
+
+        if (assignsOperand(stmt, operands))
+            return true;
+
+        for (clang::Stmt::child_iterator i = stmt->child_begin(); i != stmt->child_end(); ++i) {
+            if (mayChangeOperands(*i, operands))
+                return true;
+        }
+        return false;
+    }
+
+    /// \return Whether the operands may change when statements of a
+    /// block are executed starting from the first statement up to
+    /// and including the last statement.
+    bool mayChangeOperands(clang::CompoundStmt *block,
+                           clang::Stmt *first, clang::Stmt *last,
+                           const OperandSet &operands)
+    {
+        bool inside = false;
+        for (clang::CompoundStmt::body_iterator i = block->body_begin();
+             i != block->body_end(); ++i) {
+            inside = inside || (*i == first);
+            if (inside && mayChangeOperands(*i, operands))
+                return true;
+            if (*i == last)
+                return !inside;
+        }
+        return true;
+    }
+
+    /// Memory access that has been evaluated after a statement of a
+    /// block has been executed.
+    struct CheckedAccess {
+        CheckedAccess(clang::Stmt *statement, clang::Expr *access)
+            : statement(statement), access(access)
+        {
+        }
+
+        clang::Stmt *statement;
+        clang::Expr *access;
+    };
+
+    /// Maximum number of elements that are checked with a single
+    /// range check. The fallback area of the address space has to be
+    /// able to hold the whole range.
+    const int maxCoalescedElements = 16;
+
+    /// Memory access that may share a range check with accesses to
+    /// nearby elements.
+    struct RangeAccess {
+        RangeAccess(clang::Stmt *statement, clang::Expr *access,
+                    clang::Expr *common, int offset, bool isAnchor)
+            : statement(statement), access(access)
+            , common(common), offset(offset), isAnchor(isAnchor)
+        {
+        }
+
+        clang::Stmt *statement;
+        clang::Expr *access;
+        /// Variable part of the index, if any.
+        clang::Expr *common;
+        /// Constant part of the index.
+        int offset;
+        /// Whether the access is evaluated whenever its statement is
+        /// executed.
+        bool isAnchor;
+    };
+
+    /// Collects kernels and helper functions that have a body in
+    /// source order.
+    void collectFunctionDefinitions(
+        WebCLAnalyser &analyser, clang::SourceManager &manager,
+        std::vector<clang::FunctionDecl*> &functions)
+    {
+        WebCLAnalyser::KernelList &kernels = analyser.getKernelFunctions();
+        for (WebCLAnalyser::KernelList::iterator i = kernels.begin(); i != kernels.end(); ++i) {
+            if (i->decl->doesThisDeclarationHaveABody())
+                functions.push_back(i->decl);
+        }
+        WebCLAnalyser::FunctionDeclSet &helpers = analyser.getHelperFunctions();
+        for (WebCLAnalyser::FunctionDeclSet::iterator i = helpers.begin(); i != helpers.end(); ++i) {
+            if ((*i)->doesThisDeclarationHaveABody())
+                functions.push_back(*i);
+        }
+        std::sort(functions.begin(), functions.end(), SourceOrder(manager));
+        functions.erase(std::unique(functions.begin(), functions.end()), functions.end());
+    }
+
+    /// Collects memory accesses of a function in source order. Accesses
+    /// that are not checked are left out.
+    void collectFunctionAccesses(
+        WebCLAnalyser &analyser, clang::SourceManager &manager,
+        clang::ParentMap &parents, const std::set<clang::Expr*> &unchecked,
+        std::vector<clang::Expr*> &accesses)
+    {
+        WebCLAnalyser::MemoryAccessMap &pointerAccesses =
+            analyser.getPointerAceesses();
+        for (WebCLAnalyser::MemoryAccessMap::iterator i = pointerAccesses.begin();
+             i != pointerAccesses.end(); ++i) {
+            if (parents.hasParent(i->first) && !unchecked.count(i->first))
+                accesses.push_back(i->first);
+        }
+        std::stable_sort(accesses.begin(), accesses.end(), SourceOrder(manager));
+    }
+
+    /// Finds the innermost block containing the expression and the
+    /// statement of that block that contains the expression.
+    ///
+    /// \return Whether the expression is evaluated whenever the
+    /// statement is executed.
+    bool findEnclosingStatement(clang::ParentMap &parents, clang::Stmt *expr,
+                                clang::CompoundStmt *&block, clang::Stmt *&statement)
+    {
+        bool isUnconditional = true;
+        block = NULL;
+        statement = NULL;
+
+        clang::Stmt *child = expr;
+        for (clang::Stmt *parent = parents.getParent(child); parent;
+             child = parent, parent = parents.getParent(child)) {
+            block = llvm::dyn_cast<clang::CompoundStmt>(parent);
+            if (block) {
+                statement = child;
+                return isUnconditional;
+            }
+            isUnconditional = isUnconditional && isEvaluatedWithParent(parent, child);
+        }
+        return false;
+    }
+
+    /// Reads a constant part of an index.
+    ///
+    /// \return Whether the constant is small enough to be a distance
+    /// between coalesced elements.
+    bool getSmallOffset(const llvm::APSInt &value, int64_t &offset)
+    {
+        if (value.isSigned() ? (value.getMinSignedBits() > 64) : (value.getActiveBits() > 63))
+            return false;
+        offset = value.isSigned() ?
+            value.getSExtValue() : static_cast<int64_t>(value.getZExtValue());
+        return (offset >= -maxCoalescedElements) && (offset <= maxCoalescedElements);
+    }
+
+    /// Splits an index into a variable part and a small constant
+    /// offset. Returns false if the offset isn't small.
+    bool splitSmallOffset(clang::ASTContext &context, clang::Expr *index,
+                          clang::Expr *&common, int64_t &offset)
+    {
+        llvm::APSInt value;
+        if (index->isIntegerConstantExpr(value, context)) {
+            common = NULL;
+            return getSmallOffset(value, offset);
+        }
+
+        common = index;
+        offset = 0;
+
+        clang::QualType type = index->getType();
+        if (!type->isSignedIntegerType() && (context.getTypeSize(type) < 64))
+            return true;
+
+        clang::BinaryOperator *binary = llvm::dyn_cast<clang::BinaryOperator>(index->IgnoreParens());
+        if (!binary)
+            return true;
+
+        const clang::BinaryOperatorKind opcode = binary->getOpcode();
+        int64_t constant = 0;
+        if ((opcode == clang::BO_Add) || (opcode == clang::BO_Sub)) {
+            if (binary->getRHS()->isIntegerConstantExpr(value, context)) {
+                if (!getSmallOffset(value, constant) ||
+                    !splitSmallOffset(context, binary->getLHS(), common, offset))
+                    return false;
+                offset += (opcode == clang::BO_Add) ? constant : -constant;
+            } else if ((opcode == clang::BO_Add) &&
+                       binary->getLHS()->isIntegerConstantExpr(value, context)) {
+                if (!getSmallOffset(value, constant) ||
+                    !splitSmallOffset(context, binary->getRHS(), common, offset))
+                    return false;
+                offset += constant;
+            }
+        }
+        return (offset >= -maxCoalescedElements) && (offset <= maxCoalescedElements);
+    }
+
+    /// Splits an index into a variable part and a constant offset:
+    /// i + 1 -> (i, 1), i - 1 -> (i, -1), 2 -> (NULL, 2), i -> (i, 0)
+    ///
+    /// Only signed or 64 bit indices are split, because moving the
+    /// constant out of a narrow unsigned index would change the
+    /// result if the index wraps around. Indices with constants, or
+    /// sums of constants, that are too large to be coalesced aren't
+    /// split either, so that offsets can't overflow.
+    void splitConstantOffset(clang::ASTContext &context, clang::Expr *index,
+                             clang::Expr *&common, int &offset)
+    {
+        int64_t wide = 0;
+        if (!splitSmallOffset(context, index, common, wide)) {
+            common = index;
+            wide = 0;
+        }
+        offset = static_cast<int>(wide);
+    }
+
+    /// \return Whether executing statements of a block starting from
+    /// the first statement up to, but not including, the last
+    /// statement may skip the last statement.
+    bool mayJump(clang::CompoundStmt *block, clang::Stmt *first, clang::Stmt *last)
+    {
+        bool inside = false;
+        for (clang::CompoundStmt::body_iterator i = block->body_begin();
+             (i != block->body_end()) && (*i != last); ++i) {
+            inside = inside || (*i == first);
+            if (inside && mayJump(*i))
+                return true;
+        }
+        return false;
+    }
+}
+
+void WebCLMemoryAccessHandler::findMaskedAccesses()
+{
+    // Kernel parameters that always point to the start of a padded
+    // memory object.
+    std::set<clang::ParmVarDecl*> padded;
+    WebCLAnalyser::KernelList &kernels = analyser_.getKernelFunctions();
+    for (WebCLAnalyser::KernelList::iterator i = kernels.begin(); i != kernels.end(); ++i) {
+        for (std::vector<WebCLAnalyser::KernelArgInfo>::iterator j = i->args.begin();
+             j != i->args.end(); ++j) {
+            if (!j->isPadded || analyser_.hasAddressReferences(j->decl))
+                continue;
+            OperandSet operands;
+            operands.insert(j->decl);
+            if (!mayAssignOperands(i->decl->getBody(), operands))
+                padded.insert(j->decl);
+        }
+    }
+
+    WebCLAnalyser::MemoryAccessMap &pointerAccesses = analyser_.getPointerAceesses();
+    for (WebCLAnalyser::MemoryAccessMap::iterator i = pointerAccesses.begin();
+         i != pointerAccesses.end(); ++i) {
+        BaseIndexField bif(i->first);
+        clang::DeclRefExpr *ref =
+            llvm::dyn_cast<clang::DeclRefExpr>(bif.base->IgnoreParenImpCasts());
+        clang::ParmVarDecl *parm = ref ? llvm::dyn_cast<clang::ParmVarDecl>(ref->getDecl()) : NULL;
+        if (parm && padded.count(parm)) {
+            maskedAccesses_[i->first] = parm;
+            uncheckedAccesses_.insert(i->first);
+        }
+    }
+}
+
+unsigned WebCLMemoryAccessHandler::findReusableChecks(
+    clang::ASTContext &context, clang::FunctionDecl *func)
+{
+    clang::Stmt *body = func->getBody();
+    clang::ParentMap parents(body);
+
+    // Handle accesses of the function in source order so that
+    // earlier statements are seen before later ones.
+    WebCLAnalyser::MemoryAccessMap &pointerAccesses =
+        analyser_.getPointerAceesses();
+    std::vector<clang::Expr*> accesses;
+    collectFunctionAccesses(analyser_, context.getSourceManager(), parents,
+                            uncheckedAccesses_, accesses);
+
+    // Available checked accesses for each block and address.
+    typedef std::pair<clang::CompoundStmt*, std::string> BlockKey;
+    typedef std::vector<CheckedAccess> CheckedAccessList;
+    typedef std::map<BlockKey, CheckedAccessList> CheckedAccessMap;
+    CheckedAccessMap available;
+
+    unsigned removed = 0;
+
+    for (std::vector<clang::Expr*>::iterator i = accesses.begin(); i != accesses.end(); ++i) {
+        clang::Expr *access = *i;
+        // already covered by a range check
+        if (coalescedChecks_.count(access))
+            continue;
+
+        AddressSpaceLimits &limits =
+            kernelHandler_.getLimits(access, pointerAccesses[access]);
+
+        BaseIndexField bif(access);
+        std::stringstream key;
+        OperandSet operands;
+        key << static_cast<const void*>(&limits) << " "
+            << bif.base->getType().getAsString() << " ";
+        if (!writeOperandKey(analyser_, bif.base, key, operands))
+            continue;
+        if (bif.index) {
+            key << "[";
+            if (!writeOperandKey(analyser_, bif.index, key, operands))
+                continue;
+            key << "]";
+        }
+
+        // Look for an identical access in earlier statements of all
+        // enclosing blocks.
+        bool isReused = false;
+        bool isUnconditional = true;
+        clang::CompoundStmt *block = NULL;
+        clang::Stmt *statement = NULL;
+        clang::Stmt *child = access;
+        for (clang::Stmt *parent = parents.getParent(child);
+             parent && !isReused;
+             child = parent, parent = parents.getParent(child)) {
+
+            clang::CompoundStmt *compound = llvm::dyn_cast<clang::CompoundStmt>(parent);
+            if (!compound) {
+                if (!block)
+                    isUnconditional = isUnconditional && isEvaluatedWithParent(parent, child);
+                continue;
+            }
+
+            if (!block) {
+                block = compound;
+                statement = child;
+            }
+
+            CheckedAccessMap::iterator found = available.find(BlockKey(compound, key.str()));
+            if (found == available.end())
+                continue;
+
+            // The latest access outside the current statement has the
+            // shortest range of statements that could modify operands.
+            for (CheckedAccessList::reverse_iterator j = found->second.rbegin();
+                 j != found->second.rend(); ++j) {
+                if (j->statement == child)
+                    continue;
+                if (!mayChangeOperands(compound, j->statement, child, operands)) {
+                    std::string &checkedPointer = storedChecks_[j->access];
+                    if (checkedPointer.empty())
+                        checkedPointer = transformer_.addCheckedPointer(func, j->access);
+                    reusedChecks_[access] = checkedPointer;
+                    isReused = true;
+                    ++removed;
+                }
+                break;
+            }
+        }
+
+        if (!isReused && block && isUnconditional &&
+            (llvm::isa<clang::Expr>(statement) || llvm::isa<clang::DeclStmt>(statement))) {
+            available[BlockKey(block, key.str())].push_back(CheckedAccess(statement, access));
+        }
+    }
+
+    return removed;
+}
+
+unsigned WebCLMemoryAccessHandler::findCoalescedChecks(
+    clang::ASTContext &context, clang::FunctionDecl *func,
+    std::map<unsigned, unsigned> &maxAccess)
+{
+    clang::SourceManager &manager = context.getSourceManager();
+    clang::Stmt *body = func->getBody();
+    clang::ParentMap parents(body);
+
+    WebCLAnalyser::MemoryAccessMap &pointerAccesses =
+        analyser_.getPointerAceesses();
+    std::vector<clang::Expr*> accesses;
+    collectFunctionAccesses(analyser_, manager, parents, uncheckedAccesses_, accesses);
+
+    // Accesses of each block that have the same base and the same
+    // variable part of the index.
+    typedef std::pair<clang::CompoundStmt*, std::string> BlockKey;
+    typedef std::vector<RangeAccess> RangeAccessList;
+    typedef std::map<BlockKey, RangeAccessList> RangeAccessMap;
+    RangeAccessMap ranges;
+    std::map<BlockKey, OperandSet> rangeOperands;
+    std::vector<BlockKey> rangeOrder;
+
+    for (std::vector<clang::Expr*>::iterator i = accesses.begin(); i != accesses.end(); ++i) {
+        clang::Expr *access = *i;
+        AddressSpaceLimits &limits =
+            kernelHandler_.getLimits(access, pointerAccesses[access]);
+
+        BaseIndexField bif(access);
+        clang::Expr *common = NULL;
+        int offset = 0;
+        if (bif.index)
+            splitConstantOffset(context, bif.index, common, offset);
+
+        std::stringstream key;
+        OperandSet operands;
+        key << static_cast<const void*>(&limits) << " "
+            << bif.base->getType().getAsString() << " ";
+        if (!writeOperandKey(analyser_, bif.base, key, operands))
+            continue;
+        key << "[";
+        if (common && !writeOperandKey(analyser_, common, key, operands))
+            continue;
+        key << "]";
+
+        clang::CompoundStmt *block = NULL;
+        clang::Stmt *statement = NULL;
+        const bool isUnconditional =
+            findEnclosingStatement(parents, access, block, statement);
+        if (!block)
+            continue;
+        const bool isAnchor = isUnconditional &&
+            (llvm::isa<clang::Expr>(statement) || llvm::isa<clang::DeclStmt>(statement));
+
+        const BlockKey blockKey(block, key.str());
+        if (!ranges.count(blockKey))
+            rangeOrder.push_back(blockKey);
+        ranges[blockKey].push_back(RangeAccess(statement, access, common, offset, isAnchor));
+        rangeOperands[blockKey] = operands;
+    }
+
+    unsigned removed = 0;
+
+    for (std::vector<BlockKey>::iterator i = rangeOrder.begin(); i != rangeOrder.end(); ++i) {
+        clang::CompoundStmt *block = i->first;
+        const OperandSet &operands = rangeOperands[*i];
+        RangeAccessList &list = ranges[*i];
+
+        size_t begin = 0;
+        while (begin < list.size()) {
+            // Extend the range as long as the address operands stay
+            // the same.
+            clang::Stmt *first = list[begin].statement;
+            size_t end = begin + 1;
+            while ((end < list.size()) &&
+                   !mayChangeOperands(block, first, list[end].statement, operands)) {
+                ++end;
+            }
+
+            // Only accesses that are always evaluated may widen the
+            // range. Otherwise a valid access could be redirected to
+            // the fallback area because of an access that wouldn't
+            // have been made at all.
+            bool hasAnchors = false;
+            int minOffset = 0;
+            int maxOffset = 0;
+            for (size_t j = begin; j < end; ++j) {
+                RangeAccess &candidate = list[j];
+                if (!candidate.isAnchor || mayJump(block, first, candidate.statement))
+                    continue;
+                if (!hasAnchors || (candidate.offset < minOffset))
+                    minOffset = candidate.offset;
+                if (!hasAnchors || (candidate.offset > maxOffset))
+                    maxOffset = candidate.offset;
+                hasAnchors = true;
+            }
+
+            std::vector<RangeAccess*> members;
+            if (hasAnchors && ((maxOffset - minOffset) < maxCoalescedElements)) {
+                for (size_t j = begin; j < end; ++j) {
+                    if ((list[j].offset >= minOffset) && (list[j].offset <= maxOffset))
+                        members.push_back(&list[j]);
+                }
+            }
+
+            // The range is checked in front of the first statement,
+            // so operands must have been declared before it.
+            bool isDeclared = true;
+            clang::Stmt *hoisted = members.empty() ? NULL : members.front()->statement;
+            for (OperandSet::const_iterator j = operands.begin(); hoisted && (j != operands.end()); ++j) {
+                isDeclared = isDeclared &&
+                    manager.isBeforeInTranslationUnit((*j)->getLocation(), hoisted->getLocStart());
+            }
+
+            if ((members.size() >= 2) && isDeclared) {
+                clang::Expr *access = members.front()->access;
+                const unsigned count = maxOffset - minOffset + 1;
+                AddressSpaceLimits &limits =
+                    kernelHandler_.getLimits(access, pointerAccesses[access]);
+                const std::string checkedPointer = transformer_.addCheckedRange(
+                    func, block, hoisted, access, members.front()->common,
+                    minOffset, count, limits);
+
+                for (std::vector<RangeAccess*>::iterator j = members.begin(); j != members.end(); ++j) {
+                    coalescedChecks_[(*j)->access] =
+                        CheckedElement(checkedPointer, (*j)->offset - minOffset);
+                }
+                removed += members.size() - 1;
+
+                // the fallback area has to hold the whole range
+                BaseIndexField bif(access);
+                const unsigned addressSpace = WebCLTypes::getAddressSpace(access);
+                const unsigned rangeWidth =
+                    context.getTypeSize(bif.base->getType()->getPointeeType()) * count;
+                if (maxAccess[addressSpace] < rangeWidth)
+                    maxAccess[addressSpace] = rangeWidth;
+            }
+
+            begin = end;
+        }
+    }
+
+    return removed;
+}
+
 void WebCLMemoryAccessHandler::run(clang::ASTContext &context)
 {
     // go through memory accesses from analyser
@@ -517,12 +2289,120 @@ void WebCLMemoryAccessHandler::run(clang::ASTContext &context)
     maxAccess[clang::LangAS::opencl_local] = 8;
     maxAccess[0] = 8;
 
+    WebCLOptions options(instance_);
+    std::vector<clang::FunctionDecl*> functions;
+    collectFunctionDefinitions(analyser_, context.getSourceManager(), functions);
+
+    if (options.isEnabled(WebCLOptions::paddedBuffers_)) {
+        findMaskedAccesses();
+        info("Masked indices of %0 memory accesses through padded memory objects.")
+            << static_cast<unsigned>(maskedAccesses_.size());
+    }
+
+    if (options.isEnabled(WebCLOptions::constantIndices_)) {
+        unsigned removed = 0;
+        for (WebCLAnalyser::MemoryAccessMap::iterator i = pointerAccesses.begin();
+             i != pointerAccesses.end(); ++i) {
+            if (!uncheckedAccesses_.count(i->first) && analyser_.isConstantIndexInBounds(i->first)) {
+                uncheckedAccesses_.insert(i->first);
+                ++removed;
+            }
+        }
+        info("Removed %0 memory access checks with constant indices.") << removed;
+    }
+
+    if (options.isEnabled(WebCLOptions::escapeAnalysis_)) {
+        unsigned removed = 0;
+        for (WebCLAnalyser::MemoryAccessMap::iterator i = pointerAccesses.begin();
+             i != pointerAccesses.end(); ++i) {
+            clang::UnaryOperator *deref = llvm::dyn_cast<clang::UnaryOperator>(i->first);
+            if (!deref || (deref->getOpcode() != clang::UO_Deref))
+                continue;
+            clang::DeclRefExpr *declRef =
+                llvm::dyn_cast<clang::DeclRefExpr>(deref->getSubExpr()->IgnoreParenImpCasts());
+            clang::ParmVarDecl *parm =
+                declRef ? llvm::dyn_cast<clang::ParmVarDecl>(declRef->getDecl()) : NULL;
+            if (parm && !uncheckedAccesses_.count(deref) && analyser_.isSafePointerParameter(parm)) {
+                uncheckedAccesses_.insert(deref);
+                ++removed;
+            }
+        }
+        info("Removed %0 checks of pointer parameters that always point to a variable.") << removed;
+    }
+
+    if (options.isEnabled(WebCLOptions::padLocals_)) {
+        unsigned masked = 0;
+        for (WebCLAnalyser::MemoryAccessMap::iterator i = pointerAccesses.begin();
+             i != pointerAccesses.end(); ++i) {
+            clang::VarDecl *array = analyser_.getIndexedArray(i->first);
+            if (!uncheckedAccesses_.count(i->first) &&
+                array && transformer_.getPaddedArraySize(array)) {
+                uncheckedAccesses_.insert(i->first);
+                clampedIndices_.insert(i->first);
+                ++masked;
+            }
+        }
+        info("Masked indices of %0 accesses to padded local arrays.") << masked;
+    }
+
+    if (options.isEnabled(WebCLOptions::clampIndices_)) {
+        unsigned clamped = 0;
+        for (WebCLAnalyser::MemoryAccessMap::iterator i = pointerAccesses.begin();
+             i != pointerAccesses.end(); ++i) {
+            if (!uncheckedAccesses_.count(i->first) && analyser_.getIndexedArray(i->first)) {
+                uncheckedAccesses_.insert(i->first);
+                clampedIndices_.insert(i->first);
+                ++clamped;
+            }
+        }
+        info("Clamped indices of %0 array accesses.") << clamped;
+    }
+
+    if (options.isEnabled(WebCLOptions::coalesceChecks_)) {
+        unsigned removed = 0;
+        for (std::vector<clang::FunctionDecl*>::iterator i = functions.begin();
+             i != functions.end(); ++i) {
+            removed += findCoalescedChecks(context, *i, maxAccess);
+        }
+        info("Coalesced %0 memory access checks to range checks.") << removed;
+    }
+
+    if (options.isEnabled(WebCLOptions::reuseChecks_)) {
+        unsigned removed = 0;
+        for (std::vector<clang::FunctionDecl*>::iterator i = functions.begin();
+             i != functions.end(); ++i) {
+            removed += findReusableChecks(context, *i);
+        }
+        info("Removed %0 redundant memory access checks.") << removed;
+    }
+
     for (WebCLAnalyser::MemoryAccessMap::iterator i = pointerAccesses.begin();
         i != pointerAccesses.end(); ++i) {
 
             clang::Expr *access = i->first;
             clang::VarDecl *decl = i->second;
 
+            // constant index within array bounds or index clamped to them
+            if (uncheckedAccesses_.count(access)) {
+                MaskedAccessMap::iterator masked = maskedAccesses_.find(access);
+                clang::ArraySubscriptExpr *subscript =
+                    llvm::dyn_cast<clang::ArraySubscriptExpr>(access);
+                if (masked != maskedAccesses_.end()) {
+                    // *p and p->field access the first element
+                    if (subscript)
+                        transformer_.addMaskedMemoryAccess(subscript, masked->second);
+                } else if (clampedIndices_.count(access)) {
+                    // padded arrays have a power of two size
+                    clang::VarDecl *array = analyser_.getIndexedArray(access);
+                    unsigned long long size = transformer_.getPaddedArraySize(array);
+                    if (!size)
+                        size = context.getAsConstantArrayType(array->getType())->getSize().getZExtValue();
+                    transformer_.addArrayIndexClamp(
+                        llvm::cast<clang::ArraySubscriptExpr>(access), size);
+                }
+                continue;
+            }
+
             // update maximum access data
             unsigned addressSpace = WebCLTypes::getAddressSpace(access);
             unsigned accessWidth = context.getTypeSize(access->getType());
@@ -532,11 +2412,31 @@ void WebCLMemoryAccessHandler::run(clang::ASTContext &context)
             unsigned oldVal = maxAccess[addressSpace];
             maxAccess[addressSpace] = oldVal > accessWidth ? oldVal : accessWidth;
 
+            // access an element of a range that has already been checked
+            CheckedElementMap::iterator coalesced = coalescedChecks_.find(access);
+            if (coalesced != coalescedChecks_.end()) {
+                transformer_.addCheckedMemoryAccess(
+                    access, coalesced->second.first, coalesced->second.second);
+                continue;
+            }
+
+            // reuse pointer that has already been checked
+            CheckedPointerMap::iterator reused = reusedChecks_.find(access);
+            if (reused != reusedChecks_.end()) {
+                transformer_.addCheckedMemoryAccess(access, reused->second);
+                continue;
+            }
+
+            CheckedPointerMap::iterator stored = storedChecks_.find(access);
+            const std::string checkedPointer =
+                (stored != storedChecks_.end()) ? stored->second : "";
+
             // add memory check generation to transformer
             transformer_.addMemoryAccessCheck(
                 access,
                 1, // a single value
-                kernelHandler_.getLimits(access, decl));
+                kernelHandler_.getLimits(access, decl),
+                checkedPointer);
     }
 
     // add defines for address space specific minimum memory requirements.
@@ -564,12 +2464,15 @@ void WebCLFunctionCallHandler::handle(clang::CallExpr *callExpr,
     unsigned& fnCounter)
 {
     std::string origName = callExpr->getDirectCallee()->getNameInfo().getAsString();
-    std::string wrapperName = "_wcl_" + origName + "_" + stringify(fnCounter);
+    const std::string newName = "_wcl_" + origName + "_" + stringify(fnCounter);
+    std::string wrapperName = newName;
 
     bool success = transformer_.wrapFunctionCall(wrapperName, callExpr, kernelHandler_);
 
     if (success) {
-        ++fnCounter;
+        // a shared wrapper doesn't consume a new name
+        if (wrapperName == newName)
+            ++fnCounter;
     } else if (builtin && analyser_.hasUnsafeParameters(callExpr)) {
         // error on unknown builtin functions involving pointer arguments
         error((callExpr)->getLocStart(), "Builtin argument check is required.");
@@ -584,6 +2487,8 @@ void WebCLFunctionCallHandler::run(clang::ASTContext &context)
     WebCLAnalyser::CallExprSet internalCalls = analyser_.getInternalCalls();
 
     unsigned fnCounter = 0;
+    const bool escapeAnalysis =
+        WebCLOptions(instance_).isEnabled(WebCLOptions::escapeAnalysis_);
 
     WebCLAnalyser::FunctionDeclSet &helperFunctions = analyser_.getHelperFunctions();
     WebCLAnalyser::FunctionDeclSet withoutBody; // helper functions without body
@@ -597,6 +2502,9 @@ void WebCLFunctionCallHandler::run(clang::ASTContext &context)
     for (WebCLAnalyser::CallExprSet::const_iterator builtinCallIt = builtinCalls.begin();
         builtinCallIt != builtinCalls.end();
         ++builtinCallIt) {
+        // e.g. sincos(x, &c) can only write to c
+        if (escapeAnalysis && analyser_.isSafeBuiltinCall(*builtinCallIt))
+            continue;
         handle(*builtinCallIt, true, fnCounter);
     }
 
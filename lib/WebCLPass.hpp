@@ -33,10 +33,12 @@
 namespace clang {
     class ASTContext;
     class Expr;
+    class FunctionDecl;
     class VarDecl;
     class CallExpr;
 }
 
+class WebCLAddressSpaceHandler;
 class WebCLAnalyser;
 class WebCLTransformer;
 
@@ -61,6 +63,39 @@ protected:
     WebCLTransformer &transformer_;
 };
 
+/// Removes kernels that haven't been requested, and helper functions
+/// and constant variables that kernels don't use, so that they don't
+/// need to be transformed or compiled.
+class WebCLUnusedCodeHandler : public WebCLPass
+{
+public:
+
+    WebCLUnusedCodeHandler(
+        clang::CompilerInstance &instance,
+        WebCLAnalyser &analyser, WebCLTransformer &transformer);
+    virtual ~WebCLUnusedCodeHandler();
+
+    /// - Removes kernels that aren't listed in WCLV_KERNELS.
+    /// - Builds a call graph starting from kernels and removes
+    ///   helper functions that it doesn't reach.
+    /// - Removes constant variables that remaining functions and
+    ///   variables don't refer to.
+    ///
+    /// \see WebCLPass
+    virtual void run(clang::ASTContext &context);
+
+private:
+
+    /// Remove kernels whose names aren't requested and that requested
+    /// kernels don't call. Nothing is removed if no names are
+    /// requested.
+    unsigned removeUnrequestedKernels(const std::vector<std::string> &requested);
+    /// Remove helper functions that no kernel can call.
+    unsigned removeUnusedHelperFunctions();
+    /// Remove constant variables that have no uses.
+    unsigned removeUnusedConstantVariables();
+};
+
 /// Perform OpenCL C normalization transformations. Simplifies
 /// implementation of memory access validation algorithm, but doesn't
 /// itself do contribute to validation.
@@ -100,14 +135,36 @@ public:
 
     WebCLHelperFunctionHandler(
         clang::CompilerInstance &instance,
-        WebCLAnalyser &analyser, WebCLTransformer &transformer);
+        WebCLAnalyser &analyser, WebCLTransformer &transformer,
+        WebCLAddressSpaceHandler &addressSpaceHandler);
     virtual ~WebCLHelperFunctionHandler();
     
     /// - Adds allocation structure parameter to function signatures.
     /// - Adds allocation structure argument to corresponding calls.
     ///
+    /// With WCLV_SELECTIVE_ALLOCS only functions that access the
+    /// allocation structure, or call functions that do, are changed.
+    ///
     /// \see WebCLPass
     virtual void run(clang::ASTContext &context);
+
+private:
+
+    /// Canonical declarations of helper functions.
+    typedef std::set<clang::FunctionDecl*> FunctionSet;
+
+    /// Finds helper functions that need the allocation structure
+    /// parameter. Functions need it if they contain memory accesses,
+    /// references to relocated variables or wrapped calls, or if
+    /// they call functions that need it.
+    void findFunctionsUsingAllocations(FunctionSet &functions);
+
+    /// \return Canonical declaration of the helper function
+    /// definition that contains the location or NULL.
+    clang::FunctionDecl *getEnclosingHelper(clang::SourceLocation location);
+
+    /// Provides information about relocated variables.
+    WebCLAddressSpaceHandler &addressSpaceHandler_;
 };
 
 /// Creates address space structures.
@@ -166,9 +223,33 @@ public:
   
 private:
 
-    typedef std::set<clang::VarDecl*> AddressSpaceSet;
+    typedef std::set<clang::VarDecl*, SourceLocationOrder> AddressSpaceSet;
     std::map< AddressSpaceSet*, AddressSpaceInfo > organizedAddressSpaces_;
 
+    /// Finds arrays of scalars and vectors that are only indexed
+    /// directly, either with constants that are within the array
+    /// bounds or, if indices are clamped, with any index. Such arrays
+    /// are never accessed through pointers and they don't need to be
+    /// relocated.
+    void findDirectlyIndexedArrays(clang::ASTContext &context, bool clampedIndices,
+                                   AddressSpaceSet &arrays);
+
+    /// Pads directly indexed local arrays to a power of two number
+    /// of elements so that their indices can be masked. Arrays that
+    /// need the least padding are padded first until the padding
+    /// would exceed the given number of bytes.
+    ///
+    /// \return Number of padded arrays.
+    unsigned padLocalArrays(clang::ASTContext &context, unsigned budget);
+
+    /// Assigns relocated private and local variables to shared
+    /// slots. Each function gets the slot of its call depth, which is
+    /// the length of the longest call chain from a kernel to it. Two
+    /// functions with the same call depth can't be active at the same
+    /// time, because functions on a call chain have increasing call
+    /// depths. Local variables of all kernels share the same slot.
+    void assignSharedSlots(clang::ASTContext &context);
+
     /// Sorts address space variables.
     ///
     /// If there is need to add padding bytes etc. inside address space
@@ -251,6 +332,21 @@ private:
     /// FUTURE: Performs a more detailed analysis on whether variable
     /// limit checks can be simplified.
     void createDeclarationLimits(clang::VarDecl *decl);
+
+    /// Finds relocated private variables of a kernel that are
+    /// completely written before any private memory can be read, so
+    /// that their zero initialization can be skipped.
+    void findWrittenPrivates(clang::ASTContext &context, clang::FunctionDecl *kernel,
+                             AddressSpaceInfo &privates);
+
+    /// Finds relocated local arrays that every work-item of a
+    /// work-group writes before the first barrier of the kernel, so
+    /// that their zeroing can be skipped.
+    ///
+    /// \return Whether the kernel doesn't access local memory before
+    /// the barrier except for writing the found arrays.
+    bool findWrittenLocalArrays(clang::ASTContext &context, clang::FunctionDecl *kernel,
+                                AddressSpaceInfo &arrays);
 };
 
 /// Generates memory access checks.
@@ -272,8 +368,69 @@ public:
 
 private:
 
+    /// Finds memory accesses that can reuse the checked pointer of
+    /// an earlier identical access. An access can reuse a checked
+    /// pointer if the identical access is evaluated unconditionally
+    /// in an earlier statement of an enclosing block and if none of
+    /// the variables that the address depends on are modified in
+    /// between:
+    ///
+    /// x = a[i];
+    /// a[i] = x + 1; // reuses checked pointer of a[i] above
+    ///
+    /// \return Number of checks that were removed.
+    unsigned findReusableChecks(clang::ASTContext &context, clang::FunctionDecl *func);
+
+    /// Finds memory accesses of a block that share the base pointer
+    /// and whose indices differ only by a constant:
+    ///
+    /// x = p[i] + p[i + 1] + p[i + 2];
+    ///
+    /// The covering range of such accesses is checked once in front
+    /// of the first statement and the accesses use the checked
+    /// pointer without further checks. Field accesses through the
+    /// same pointer (p->a, p->b) are handled as accesses to the same
+    /// element.
+    ///
+    /// \return Number of checks that were removed.
+    unsigned findCoalescedChecks(clang::ASTContext &context, clang::FunctionDecl *func,
+                                 std::map<unsigned, unsigned> &maxAccess);
+
+    /// Finds accesses through kernel parameters of padded memory
+    /// objects that are never changed to point elsewhere. Indices
+    /// of such accesses can be masked instead of checking the
+    /// accessed address:
+    ///
+    /// p[i] -> p[(i) & _wcl_p_mask]
+    ///
+    /// Accesses without an index, e.g. *p or p->field, always access
+    /// the first element and don't need to be checked at all.
+    void findMaskedAccesses();
+
     /// Contains information about address space limits.
     WebCLKernelHandler &kernelHandler_;
+
+    /// Maps memory accesses to variables holding checked pointers.
+    typedef std::map<clang::Expr*, std::string> CheckedPointerMap;
+    /// Accesses that store their checked pointer for later use.
+    CheckedPointerMap storedChecks_;
+    /// Accesses that reuse a stored checked pointer.
+    CheckedPointerMap reusedChecks_;
+
+    /// Checked pointer to a range and element offset within it.
+    typedef std::pair<std::string, int> CheckedElement;
+    typedef std::map<clang::Expr*, CheckedElement> CheckedElementMap;
+    /// Accesses covered by a range check.
+    CheckedElementMap coalescedChecks_;
+
+    /// Accesses that aren't checked with pointer clamps, because they
+    /// can't go out of bounds or because their index is clamped.
+    std::set<clang::Expr*> uncheckedAccesses_;
+    /// Array accesses whose index is clamped to array bounds.
+    std::set<clang::Expr*> clampedIndices_;
+    /// Accesses through padded memory object parameters.
+    typedef std::map<clang::Expr*, clang::ParmVarDecl*> MaskedAccessMap;
+    MaskedAccessMap maskedAccesses_;
 };
 
 /// Generates memory access checks and disallows calls to undeclared functions.
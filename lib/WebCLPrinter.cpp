@@ -21,6 +21,8 @@
 ** MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
 */
 
+#include "WebCLDigest.hpp"
+#include "WebCLOptions.hpp"
 #include "WebCLPrinter.hpp"
 #include "WebCLTransformer.hpp"
 
@@ -78,9 +80,38 @@ void WebCLValidatorPrinter::run(clang::ASTContext &context)
         return;
 
     output_.clear();
+    hash_.clear();
     llvm::raw_string_ostream os(output_);
-    if (!print(os, "// WebCL Validator: validation stage.\n")) {
+    // Hash the output while it's being printed.
+    WebCLDigest digest;
+    WebCLDigestStream hashed(os, digest);
+    const bool compact =
+        WebCLOptions(instance_).isEnabled(WebCLOptions::compactOutput_);
+    if (!print(hashed, compact ? "" : "// WebCL Validator: validation stage.\n")) {
         fatal("Can't print validator output.");
         return;
     }
+    hashKernels(digest);
+    hash_ = digest.final();
+}
+
+void WebCLValidatorPrinter::hashKernels(WebCLDigest &digest)
+{
+    // Separate each field with a NUL so that different metadata
+    // can't produce the same byte sequence.
+    const std::string separator(1, '\0');
+
+    WebCLAnalyser::KernelList &kernels = analyser_.getKernelFunctions();
+    for (WebCLAnalyser::KernelList::iterator i = kernels.begin(); i != kernels.end(); ++i) {
+        digest.update(separator + i->name + separator);
+        for (std::vector<WebCLAnalyser::KernelArgInfo>::iterator j = i->args.begin();
+             j != i->args.end(); ++j) {
+            std::string flags;
+            flags += static_cast<char>('0' + j->pointerKind);
+            flags += static_cast<char>('0' + j->imageKind);
+            flags += j->isPadded ? '1' : '0';
+            flags += j->inConstantRegion ? '1' : '0';
+            digest.update(j->name + separator + j->reducedTypeName + separator + flags + separator);
+        }
+    }
 }
@@ -33,6 +33,8 @@ namespace llvm {
     class raw_ostream;
 }
 
+class WebCLDigest;
+
 namespace clang {
     class Rewriter;
 }
@@ -76,10 +78,18 @@ public:
     /// Get transformed source
     const std::string &getOutput() const { return output_; }
 
+    /// Get digest of transformed source and kernel metadata
+    const std::string &getHash() const { return hash_; }
+
 private:
 
+    /// Adds kernel names and argument metadata to the digest.
+    void hashKernels(WebCLDigest &digest);
+
     /// Stores transformed source after a succesful run
     std::string output_;
+    /// Stores digest of the output and kernel metadata
+    std::string hash_;
 };
 
 #endif // WEBCLVALIDATOR_WEBCLPRINTER
@@ -183,7 +183,7 @@ WebCLValidatorTool::~WebCLValidatorTool()
 
 clang::FrontendAction *WebCLValidatorTool::create()
 {
-    WebCLAction *action = new WebCLValidatorAction(validatedSource_, kernels_);
+    WebCLAction *action = new WebCLValidatorAction(validatedSource_, kernels_, programHash_);
     action->setExtensions(extensions_);
     action->setUsedExtensionsStorage(usedExtensions_);
     return action;
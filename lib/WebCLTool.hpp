@@ -174,6 +174,8 @@ public:
     const std::string &getValidatedSource() const { return validatedSource_; }
     /// Ditto for kernel info
     const WebCLAnalyser::KernelList &getKernels() const { return kernels_; }
+    /// Ditto for digest of validated source and kernel info
+    const std::string &getProgramHash() const { return programHash_; }
 
 private:
 
@@ -181,6 +183,8 @@ private:
     std::string validatedSource_;
     // ditto for kernels
     WebCLAnalyser::KernelList kernels_;
+    // ditto for digest
+    std::string programHash_;
 };
 
 #endif // WEBCLVALIDATOR_WEBCLTOOL
@@ -22,6 +22,7 @@
 */
 
 #include "WebCLDebug.hpp"
+#include "WebCLOptions.hpp"
 #include "WebCLTransformer.hpp"
 #include "WebCLVisitor.hpp"
 #include "WebCLPass.hpp"
@@ -37,6 +38,9 @@
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Rewrite/Core/Rewriter.h"
 
+#include <algorithm>
+#include <cctype>
+
 namespace {
     typedef std::vector<clang::Expr*> ExprVector;
     typedef std::list<std::pair<std::string, std::string> > FunctionArgumentList;
@@ -98,6 +102,11 @@ public:
     /// Return the number of arguments the builtin function accepts
     virtual unsigned getNumArgs() const = 0;
 
+    /// Is the wrapper matched only by the name and number of
+    /// arguments of the call? Otherwise matchesCallExpr and
+    /// matchesVarDecl are consulted for each call and declaration.
+    virtual bool isNamed() const;
+
     /// Does this wrapper match the signature of the call?
     virtual bool matchesCallExpr(clang::CompilerInstance &instance, clang::CallExpr *callExpr);
 
@@ -130,6 +139,11 @@ WebCLTransformer::FunctionCallWrapper::~FunctionCallWrapper()
 // nothing    
 }
 
+bool WebCLTransformer::FunctionCallWrapper::isNamed() const
+{
+    return true;
+}
+
 bool WebCLTransformer::FunctionCallWrapper::matchesCallExpr(clang::CompilerInstance &instance, clang::CallExpr *callExpr)
 {
     const clang::FunctionDecl *callee = callExpr->getDirectCallee();
@@ -283,6 +297,7 @@ namespace {
         std::string getName() const;
         unsigned getNumArgs() const;
 
+        bool isNamed() const;
         bool matchesCallExpr(clang::CompilerInstance &instance, clang::CallExpr *callExpr);
         bool matchesVarDecl(clang::CompilerInstance &instance, clang::VarDecl *callExpr);
 
@@ -397,12 +412,15 @@ namespace {
         std::string name,
     bool addAddressSpaceRecordArg)
     {
-        WebCLConfiguration cfg;
+        WebCLConfiguration cfg(WebCLOptions(instance).isEnabled(WebCLOptions::compactOutput_));
 
         FunctionArgumentList newArguments;
       
         if (addAddressSpaceRecordArg) {
-            newArguments.push_back(std::make_pair(cfg.addressSpaceRecordType_ + "*", cfg.addressSpaceRecordName_));
+            std::string recordType = cfg.addressSpaceRecordType_ + "*";
+            if (WebCLOptions(instance).isEnabled(WebCLOptions::restrictAllocs_))
+                recordType += cfg.addressSpaceRecordQualifiers_;
+            newArguments.push_back(std::make_pair(recordType, cfg.addressSpaceRecordName_));
         }
       
         for (size_t argIdx = 0; argIdx < callExpr->getNumArgs(); ++argIdx) {
@@ -434,7 +452,7 @@ namespace {
 
     WrappedFunction VLoad::wrapFunction(WebCLTransformer &transformer, clang::CompilerInstance &instance, clang::CallExpr *callExpr, const ExprVector &arguments, WebCLKernelHandler &kernelHandler, WebCLRewriter &rewriter) const
     {
-	WebCLConfiguration cfg;
+	WebCLConfiguration cfg(WebCLOptions(instance).isEnabled(WebCLOptions::compactOutput_));
 
 	clang::Expr *pointerArg = arguments[1];
 
@@ -465,11 +483,21 @@ namespace {
 	    zeroValue = WebCLTypes::initialZeroValues().find(returnTypeStr)->second;
 	}
 	body
-	    << indent << ptrTypeStr << " ptr = arg1 + " << origDataWidth << " * (size_t) arg0;\n"
-	    << indent << "if (" << transformer.getCheckFunctionCall(WebCLTransformer::CHECK_CHECK, "ptr", ptrTypeStr, origDataWidth, limits) << ")\n"
-	    << indent__ << "return " << getName() << "(0, ptr);\n"
-	    << indent << "else\n"
-	    << indent__ << "return " << zeroValue << ";\n";
+	    << indent << ptrTypeStr << " ptr = arg1 + " << origDataWidth << " * (size_t) arg0;\n";
+	const std::string inlineCheck = transformer.getInlineLimitCheck("ptr", ptrTypeStr, origDataWidth, limits);
+	if (inlineCheck.size()) {
+	    // The fallback can't be a select, because it would load from
+	    // the unchecked address.
+	    body
+		<< indent << "return (" << inlineCheck << ") ? "
+		<< getName() << "(0, ptr) : " << zeroValue << ";\n";
+	} else {
+	    body
+		<< indent << "if (" << transformer.getCheckFunctionCall(WebCLTransformer::CHECK_CHECK, "ptr", ptrTypeStr, origDataWidth, limits) << ")\n"
+		<< indent__ << "return " << getName() << "(0, ptr);\n"
+		<< indent << "else\n"
+		<< indent__ << "return " << zeroValue << ";\n";
+	}
 
 	return WrappedFunction(returnTypeStr + stringify(width_), body.str());
     }
@@ -506,7 +534,7 @@ namespace {
 
     WrappedFunction VStore::wrapFunction(WebCLTransformer &transformer, clang::CompilerInstance &instance, clang::CallExpr *callExpr, const ExprVector &arguments, WebCLKernelHandler &kernelHandler, WebCLRewriter &rewriter) const
     {
-	WebCLConfiguration cfg;
+	WebCLConfiguration cfg(WebCLOptions(instance).isEnabled(WebCLOptions::compactOutput_));
 
 	clang::Expr *pointerArg = arguments[2];
 
@@ -523,9 +551,12 @@ namespace {
 	std::string indent = cfg.getIndentation(1);
 	std::string indent__ = cfg.getIndentation(2);
 	std::stringstream body;
+	std::string check = transformer.getInlineLimitCheck("ptr", ptrTypeStr, origDataWidth, limits);
+	if (check.empty())
+	    check = transformer.getCheckFunctionCall(WebCLTransformer::CHECK_CHECK, "ptr", ptrTypeStr, origDataWidth, limits);
 	body
 	    << indent << ptrTypeStr << " ptr = arg2 + " << origDataWidth << " * (size_t) arg1;\n"
-	    << indent << "if (" << transformer.getCheckFunctionCall(WebCLTransformer::CHECK_CHECK, "ptr", ptrTypeStr, origDataWidth, limits) << ")\n"
+	    << indent << "if (" << check << ")\n"
 	    << indent__ << getName() << "(arg0, 0, ptr);\n";
 
 	return WrappedFunction("void", body.str());
@@ -583,7 +614,7 @@ namespace {
 
     WrappedFunction WriteImage::wrapFunction(WebCLTransformer &transformer, clang::CompilerInstance &instance, clang::CallExpr *callExpr, const ExprVector &arguments, WebCLKernelHandler &kernelHandler, WebCLRewriter &rewriter) const
     {
-	WebCLConfiguration cfg;
+	WebCLConfiguration cfg(WebCLOptions(instance).isEnabled(WebCLOptions::compactOutput_));
 
 	clang::Expr *imageArg = arguments[0];
 	clang::Expr *coordArg = arguments[1];
@@ -625,6 +656,11 @@ namespace {
         return 0;
     }
 
+    bool SamplerType::isNamed() const
+    {
+        return false;
+    }
+
     bool SamplerType::matchesCallExpr(clang::CompilerInstance &instance, clang::CallExpr *callExpr)
     {
         for (size_t argIdx = 0; argIdx < callExpr->getNumArgs(); ++argIdx) {
@@ -688,7 +724,7 @@ namespace {
 
     WrappedFunction GenericWrapper::wrapFunction(WebCLTransformer &transformer, clang::CompilerInstance &instance, clang::CallExpr *callExpr, const ExprVector &arguments, WebCLKernelHandler &kernelHandler, WebCLRewriter &rewriter) const
     {
-        WebCLConfiguration cfg;
+        WebCLConfiguration cfg(WebCLOptions(instance).isEnabled(WebCLOptions::compactOutput_));
 
         clang::Expr *pointerArg = arguments[ptrArgIndex_];
         std::string ptrArgName = "arg" + stringify(ptrArgIndex_);
@@ -732,7 +768,20 @@ WebCLTransformer::WebCLTransformer(
     clang::CompilerInstance &instance, clang::Rewriter &rewriter)
     : WebCLReporter(instance)
     , wclRewriter_(instance, rewriter)
-    , cfg_()
+    , checkedPointerCount_(0)
+    , unsignedOffsetChecks_(
+        WebCLOptions(instance).isEnabled(WebCLOptions::unsignedOffsetChecks_))
+    , limitSearchThreshold_(
+        WebCLOptions(instance).getValue(WebCLOptions::searchLimits_, 0))
+    , restrictAllocs_(
+        WebCLOptions(instance).isEnabled(WebCLOptions::restrictAllocs_))
+    , fusedLocalZeroing_(
+        WebCLOptions(instance).isEnabled(WebCLOptions::fusedLocalZeroing_))
+    , compactOutput_(
+        WebCLOptions(instance).isEnabled(WebCLOptions::compactOutput_))
+    , inlineVectorChecks_(
+        WebCLOptions(instance).isEnabled(WebCLOptions::inlineVectorChecks_))
+    , cfg_(compactOutput_)
 {
     // Make a list of builtin wrappers
     for (UintList::const_iterator widthIt = cfg_.dataWidths_.begin();
@@ -781,6 +830,16 @@ WebCLTransformer::WebCLTransformer(
     // note: needs to be inserted after other, more specific, wrappers, as only the first matching handler is
     // executed. In this case this needs to be before ReadImage.
     functionWrappers_.push_back(new SamplerType());
+
+    // Index the wrappers so that calls don't need to visit all of them.
+    for (FunctionCallWrapperList::iterator it = functionWrappers_.begin();
+         it != functionWrappers_.end();
+         ++it) {
+        if ((*it)->isNamed())
+            namedWrappers_[(*it)->getName()].push_back(*it);
+        else
+            unnamedWrappers_.push_back(*it);
+    }
 }
 
 void WebCLTransformer::addGenericWrappers(const StringList& list, 
@@ -822,9 +881,7 @@ bool WebCLTransformer::rewrite()
     // do all replacements stored in refactoring first ()
     flushQueuedTransformations();
 
-    status = status && rewritePrologue();
-  
-    std::set<const clang::FunctionDecl*> kernelOrFunction;
+    std::set<const clang::FunctionDecl*, SourceLocationOrder> kernelOrFunction;
     for (FunctionPrologueMap::iterator iter = kernelPrologues_.begin();
          iter != kernelPrologues_.end(); iter++) {
       kernelOrFunction.insert(iter->first);
@@ -835,7 +892,7 @@ bool WebCLTransformer::rewrite()
       kernelOrFunction.insert(iter->first);
     }
   
-    for (std::set<const clang::FunctionDecl*>::iterator iter = kernelOrFunction.begin();
+    for (std::set<const clang::FunctionDecl*, SourceLocationOrder>::iterator iter = kernelOrFunction.begin();
          iter != kernelOrFunction.end(); iter++) {
 
       const clang::FunctionDecl *func = *iter;
@@ -861,6 +918,12 @@ bool WebCLTransformer::rewrite()
 
     flushQueuedTransformations();
 
+    // The module prologue is written last so that compact output
+    // can see everything that refers to general definitions.
+    status = status && rewritePrologue();
+
+    flushQueuedTransformations();
+
     return status;
 }
 
@@ -878,16 +941,60 @@ std::stringstream& WebCLTransformer::functionPrologue(
     return *prologues[kernel];
 }
 
+void WebCLTransformer::groupSharedSlots(
+    AddressSpaceInfo &as, AddressSpaceInfo &unshared, SharedSlots &slots)
+{
+  for (AddressSpaceInfo::iterator declIter = as.begin();
+       declIter != as.end(); ++declIter) {
+    SharedSlotMap::iterator shared = sharedSlots_.find(*declIter);
+    if (shared == sharedSlots_.end()) {
+      unshared.push_back(*declIter);
+      continue;
+    }
+
+    SlotGroups &groups = slots[shared->second.first];
+    SlotGroups::iterator group = groups.begin();
+    while ((group != groups.end()) && (group->first != shared->second.second))
+      ++group;
+    if (group == groups.end())
+      group = groups.insert(groups.end(), std::make_pair(shared->second.second, AddressSpaceInfo()));
+    group->second.push_back(*declIter);
+  }
+}
+
 std::string WebCLTransformer::addressSpaceInfoAsStruct(AddressSpaceInfo &as)
 {
   std::stringstream retVal;
   retVal << "{\n";
-  for (AddressSpaceInfo::iterator declIter = as.begin();
-       declIter != as.end(); ++declIter) {
+
+  AddressSpaceInfo unshared;
+  SharedSlots slots;
+  groupSharedSlots(as, unshared, slots);
+
+  for (AddressSpaceInfo::iterator declIter = unshared.begin();
+       declIter != unshared.end(); ++declIter) {
     retVal << cfg_.indentation_;
     emitVarDeclToStruct(retVal, (*declIter));
     retVal << ";\n";
   }
+
+  for (SharedSlots::iterator slot = slots.begin();
+       slot != slots.end(); ++slot) {
+    retVal << cfg_.indentation_ << "union {\n";
+    for (SlotGroups::iterator group = slot->second.begin();
+         group != slot->second.end(); ++group) {
+      retVal << cfg_.getIndentation(2) << "struct {\n";
+      for (AddressSpaceInfo::iterator declIter = group->second.begin();
+           declIter != group->second.end(); ++declIter) {
+        retVal << cfg_.getIndentation(3);
+        emitVarDeclToStruct(retVal, (*declIter));
+        retVal << ";\n";
+      }
+      retVal << cfg_.getIndentation(2) << "} " << cfg_.getNameOfSlotGroupField(group->first) << ";\n";
+    }
+    retVal << cfg_.indentation_ << "} " << cfg_.getNameOfSlotField(slot->first) << ";\n";
+  }
+
   retVal << "}";
   return retVal.str();
 }
@@ -941,6 +1048,13 @@ std::string WebCLTransformer::addressSpaceLimitsAsStruct(AddressSpaceLimits &asL
             break;
         }
     }
+
+    if (asLimits.hasRegionLimits()) {
+        const std::string prefix =
+            cfg_.indentation_ + "__" + cfg_.constantAddressSpace_ + " uchar *";
+        retVal << prefix << cfg_.constantRegionMinField_ << ";\n";
+        retVal << prefix << cfg_.constantRegionMaxField_ << ";\n";
+    }
   
     for (AddressSpaceLimits::LimitList::iterator declIter = asLimits.getDynamicLimits().begin();
          declIter != asLimits.getDynamicLimits().end(); ++declIter) {
@@ -993,6 +1107,18 @@ std::string WebCLTransformer::addressSpaceLimitsInitializer(
         }
     }
 
+    if (asLimits.hasRegionLimits()) {
+        retVal << comma;
+        if (constantRegionKernels_.count(kernelFunc)) {
+            const std::string &name = cfg_.constantRegionParameter_;
+            retVal << "&" << name << "[0], "
+                   << "&" << name << "[" << cfg_.constantRegionSizeParameter_ << "]";
+        } else {
+            retVal << "0, 0";
+        }
+        comma = ",";
+    }
+
     for (AddressSpaceLimits::LimitList::iterator declIter = asLimits.getDynamicLimits().begin();
          declIter != asLimits.getDynamicLimits().end(); ++declIter) {
 
@@ -1005,8 +1131,12 @@ std::string WebCLTransformer::addressSpaceLimitsInitializer(
             const std::string name = decl->getName();
             retVal << "&" << name
                    << "[0], "
-                   << "&" << name
-                   << "[" << cfg_.getNameOfSizeParameter(name) << "]";
+                   << "&" << name;
+            if (isPaddedBuffer(decl)) {
+                retVal << "[" << cfg_.getNameOfMaskParameter(name) << " + 1]";
+            } else {
+                retVal << "[" << cfg_.getNameOfSizeParameter(name) << "]";
+            }
         } else {
             retVal << "0, 0";
         }
@@ -1045,6 +1175,14 @@ void WebCLTransformer::createPrivateAddressSpaceTypedef(AddressSpaceInfo &as)
     createAddressSpaceTypedef(as, cfg_.privateRecordType_, cfg_.getNameOfAlignMacro("private"));
 }
 
+void WebCLTransformer::addSharedSlot(
+    const clang::VarDecl *decl, unsigned slot, const std::string &function)
+{
+    sharedSlots_[decl] = std::make_pair(slot, function);
+    cfg_.setPathOfRelocatedVariable(
+        decl, cfg_.getNameOfSlotField(slot) + "." + cfg_.getNameOfSlotGroupField(function) + ".");
+}
+
 void WebCLTransformer::createLocalAddressSpaceTypedef(AddressSpaceInfo &as)
 {
     createAddressSpaceTypedef(as, cfg_.localRecordType_, cfg_.getNameOfAlignMacro("local"));
@@ -1055,6 +1193,73 @@ void WebCLTransformer::createConstantAddressSpaceTypedef(AddressSpaceInfo &as)
     createAddressSpaceTypedef(as, cfg_.constantRecordType_, cfg_.getNameOfAlignMacro("constant"));
 }
 
+namespace {
+
+    /// Layout of a structure or union that is being built.
+    struct RecordLayout
+    {
+        RecordLayout() : size(0), alignment(1) {}
+
+        void addField(unsigned long long fieldSize, unsigned long long fieldAlignment, bool isUnion)
+        {
+            if (isUnion) {
+                size = std::max(size, fieldSize);
+            } else {
+                size = (size + fieldAlignment - 1) / fieldAlignment * fieldAlignment + fieldSize;
+            }
+            alignment = std::max(alignment, fieldAlignment);
+        }
+
+        unsigned long long paddedSize() const
+        {
+            return (size + alignment - 1) / alignment * alignment;
+        }
+
+        unsigned long long size;
+        unsigned long long alignment;
+    };
+}
+
+unsigned long long WebCLTransformer::getAddressSpaceSize(AddressSpaceInfo &as)
+{
+    clang::ASTContext &context = instance_.getASTContext();
+    AddressSpaceInfo unshared;
+    SharedSlots slots;
+    groupSharedSlots(as, unshared, slots);
+
+    RecordLayout layout;
+    for (AddressSpaceInfo::iterator i = unshared.begin(); i != unshared.end(); ++i) {
+        layout.addField(getFieldSize(*i),
+                        context.getTypeAlignInChars((*i)->getType()).getQuantity(), false);
+    }
+    for (SharedSlots::iterator slot = slots.begin(); slot != slots.end(); ++slot) {
+        RecordLayout slotLayout;
+        for (SlotGroups::iterator group = slot->second.begin();
+             group != slot->second.end(); ++group) {
+            RecordLayout groupLayout;
+            for (AddressSpaceInfo::iterator i = group->second.begin();
+                 i != group->second.end(); ++i) {
+                groupLayout.addField(getFieldSize(*i),
+                                     context.getTypeAlignInChars((*i)->getType()).getQuantity(), false);
+            }
+            slotLayout.addField(groupLayout.paddedSize(), groupLayout.alignment, true);
+        }
+        layout.addField(slotLayout.paddedSize(), slotLayout.alignment, false);
+    }
+    return layout.paddedSize();
+}
+
+unsigned long long WebCLTransformer::getFieldSize(const clang::VarDecl *decl)
+{
+    clang::ASTContext &context = instance_.getASTContext();
+    const unsigned long long paddedSize = getPaddedArraySize(decl);
+    if (paddedSize) {
+        const clang::ConstantArrayType *array = context.getAsConstantArrayType(decl->getType());
+        return paddedSize * context.getTypeSizeInChars(array->getElementType()).getQuantity();
+    }
+    return context.getTypeSizeInChars(decl->getType()).getQuantity();
+}
+
 void WebCLTransformer::createAddressSpaceLimitsTypedef(
     AddressSpaceLimits &limits, const std::string &name)
 {
@@ -1113,6 +1318,11 @@ void WebCLTransformer::createProgramAllocationsTypedef(
         modulePrologue_ << cfg_.indentation_ << cfg_.privateRecordType_<< " " << cfg_.privatesField_ << ";\n";
         createAddressSpaceNullField(cfg_.privateNullField_, 0);
     }
+    // limit tables are last so that they can be left out from
+    // initializers
+    createLimitTableField(globalLimits);
+    createLimitTableField(constantLimits);
+    createLimitTableField(localLimits);
     modulePrologue_ << "} " << cfg_.addressSpaceRecordType_ << ";\n\n";
 }
 
@@ -1142,13 +1352,73 @@ void WebCLTransformer::createAddressSpaceLimitsInitializer(
     createAddressSpaceLimitsNullInitializer(out, limits.getAddressSpace());
 }
 
+void WebCLTransformer::createAddressSpaceLimitsAssignment(
+    std::ostream &out, clang::FunctionDecl *kernel, AddressSpaceLimits &limits,
+    const std::string &type, const std::string &field, const std::string &nullField)
+{
+    if (limits.empty())
+        return;
+
+    const std::string prefix = cfg_.indentation_ + cfg_.programRecordName_ + ".";
+    out << prefix << field << " = (" << type << ")"
+        << addressSpaceLimitsInitializer(kernel, limits) << ";\n";
+    out << prefix << nullField << " = ";
+    createAddressSpaceLimitsNullInitializer(out, limits.getAddressSpace());
+    out << ";\n";
+}
+
+void WebCLTransformer::createPrivateAreaZeroing(
+    std::ostream &out, const AddressSpaceInfo &writtenPrivates)
+{
+    // Zero the gaps between variables that the kernel writes
+    // itself. The variables are in the same order as the fields.
+    const std::string privates =
+        "&" + cfg_.addressSpaceRecordName_ + "->" + cfg_.privatesField_;
+    std::string begin = privates;
+    for (AddressSpaceInfo::const_iterator i = writtenPrivates.begin();
+         i != writtenPrivates.end(); ++i) {
+        const std::string field = "&" + cfg_.getReferenceToRelocatedVariable(*i);
+        out << cfg_.indentation_ << cfg_.privateRangeZeroingMacro_
+            << "(" << begin << ", " << field << ");\n";
+        begin = "(" + field + " + 1)";
+    }
+    out << cfg_.indentation_ << cfg_.privateRangeZeroingMacro_
+        << "(" << begin << ", (" << privates << " + 1));\n";
+}
+
 void WebCLTransformer::createProgramAllocationsAllocation(
     clang::FunctionDecl *kernelFunc, AddressSpaceLimits &globalLimits,
     AddressSpaceLimits &constantLimits, AddressSpaceLimits &localLimits,
-    AddressSpaceInfo &privateAs)
+    AddressSpaceInfo &privateAs, const AddressSpaceInfo &writtenPrivates)
 {
     std::ostream &out = functionPrologue(kernelPrologues_, kernelFunc);
 
+    if (!writtenPrivates.empty()) {
+        // An initializer would zero all private variables, so fields
+        // are assigned one by one instead.
+        out << "\n" << cfg_.indentation_
+            << cfg_.addressSpaceRecordType_ << " " << cfg_.programRecordName_ << ";\n";
+        createAddressSpaceLimitsAssignment(
+            out, kernelFunc, globalLimits,
+            cfg_.globalLimitsType_, cfg_.globalLimitsField_, cfg_.globalNullField_);
+        createAddressSpaceLimitsAssignment(
+            out, kernelFunc, constantLimits,
+            cfg_.constantLimitsType_, cfg_.constantLimitsField_, cfg_.constantNullField_);
+        createAddressSpaceLimitsAssignment(
+            out, kernelFunc, localLimits,
+            cfg_.localLimitsType_, cfg_.localLimitsField_, cfg_.localNullField_);
+        out << cfg_.indentation_ << cfg_.programRecordName_ << "."
+            << cfg_.privateNullField_ << " = 0;\n";
+        out << cfg_.indentation_ << getAddressSpaceRecordPointer()
+            << " = &" << cfg_.programRecordName_ << ";\n";
+        createPrivateAreaZeroing(out, writtenPrivates);
+
+        createLimitTableInitializer(out, globalLimits);
+        createLimitTableInitializer(out, constantLimits);
+        createLimitTableInitializer(out, localLimits);
+        return;
+    }
+
     out << "\n" << cfg_.indentation_
         << cfg_.addressSpaceRecordType_ << " " << cfg_.programRecordName_ << " = {\n";
 
@@ -1187,8 +1457,69 @@ void WebCLTransformer::createProgramAllocationsAllocation(
     }
 
     out << "\n" << cfg_.indentation_ << "};\n";
-    out << cfg_.indentation_ << cfg_.addressSpaceRecordType_ << " *"
-        << cfg_.addressSpaceRecordName_ << " = &" << cfg_.programRecordName_ << ";\n";
+    out << cfg_.indentation_ << getAddressSpaceRecordPointer()
+        << " = &" << cfg_.programRecordName_ << ";\n";
+
+    createLimitTableInitializer(out, globalLimits);
+    createLimitTableInitializer(out, constantLimits);
+    createLimitTableInitializer(out, localLimits);
+}
+
+std::string WebCLTransformer::getAddressSpaceRecordPointer() const
+{
+    std::string pointer = cfg_.addressSpaceRecordType_ + " *";
+    if (restrictAllocs_)
+        pointer += cfg_.addressSpaceRecordQualifiers_ + " ";
+    return pointer + cfg_.addressSpaceRecordName_;
+}
+
+bool WebCLTransformer::hasLimitTable(unsigned limitCount) const
+{
+    return limitSearchThreshold_ && (limitCount > limitSearchThreshold_);
+}
+
+void WebCLTransformer::createLimitTableField(AddressSpaceLimits &limits)
+{
+    if (!hasLimitTable(limits.count()))
+        return;
+
+    modulePrologue_ << cfg_.indentation_ << "ulong "
+                    << cfg_.getNameOfLimitTableField(limits.getAddressSpace())
+                    << "[" << (2 * limits.count()) << "];\n";
+}
+
+void WebCLTransformer::createLimitTableInitializer(
+    std::ostream &out, AddressSpaceLimits &limits)
+{
+    if (!hasLimitTable(limits.count()))
+        return;
+
+    const unsigned addressSpace = limits.getAddressSpace();
+    const std::string table = cfg_.getLimitTableRef(addressSpace);
+    unsigned index = 0;
+
+    if (limits.hasStaticallyAllocatedLimits()) {
+        out << cfg_.indentation_ << cfg_.limitTableSetMacro_ << "("
+            << table << ", " << index++ << ", "
+            << cfg_.getStaticLimitRef(addressSpace) << ");\n";
+    }
+
+    if (limits.hasRegionLimits()) {
+        out << cfg_.indentation_ << cfg_.limitTableSetMacro_ << "("
+            << table << ", " << index++ << ", "
+            << cfg_.getRegionLimitRef() << ");\n";
+    }
+
+    AddressSpaceLimits::LimitList &dynamicLimits = limits.getDynamicLimits();
+    for (AddressSpaceLimits::LimitList::iterator i = dynamicLimits.begin();
+         i != dynamicLimits.end(); ++i) {
+        out << cfg_.indentation_ << cfg_.limitTableSetMacro_ << "("
+            << table << ", " << index++ << ", "
+            << cfg_.getDynamicLimitRef(*i) << ");\n";
+    }
+
+    out << cfg_.indentation_ << cfg_.limitTableSortMacro_ << "("
+        << table << ", " << limits.count() << ");\n";
 }
 
 void WebCLTransformer::createAddressSpaceNullAllocation(
@@ -1256,28 +1587,65 @@ void WebCLTransformer::initializeAddressSpaceNull(clang::FunctionDecl *kernel,
   out << ";\n";
   
   out << cfg_.indentation_
-      << "if (" << cfg_.getNameOfAddressSpaceNullPtrRef(limits.getAddressSpace()) << " == (" << nullType << ")0) return; // not enough space to meet the minimum access. Would be great if we could give info about the problem for the user. \n";
+      << "if (" << cfg_.getNameOfAddressSpaceNullPtrRef(limits.getAddressSpace()) << " == (" << nullType << ")0) return;";
+  if (!compactOutput_)
+      out << " // not enough space to meet the minimum access. Would be great if we could give info about the problem for the user. ";
+  out << "\n";
 }
 
 void WebCLTransformer::createLocalRangeZeroing(
     std::ostream &out, const std::string &arguments)
 {
+    if (fusedLocalZeroing_) {
+        out << cfg_.indentation_
+            << cfg_.localRangeFillMacro_ << "(" << arguments << ", "
+            << cfg_.localItemIndexVariable_ << ", "
+            << cfg_.localItemCountVariable_ << ");\n";
+        return;
+    }
+
     out << cfg_.indentation_
         << cfg_.localRangeZeroingMacro_ << "(" << arguments << ");\n";
 }
 
 void WebCLTransformer::createLocalAreaZeroing(
-    clang::FunctionDecl *kernelFunc, AddressSpaceLimits &localLimits)
+    clang::FunctionDecl *kernelFunc, AddressSpaceLimits &localLimits,
+    const AddressSpaceInfo &writtenArrays, bool needsBarrier)
 {
     if (localLimits.empty())
         return;
 
     std::ostream &out = functionPrologue(kernelPrologues_, kernelFunc);
 
-    out << "\n" << cfg_.indentation_ << "// => Local memory zeroing.\n";
+    if (!compactOutput_)
+        out << "\n" << cfg_.indentation_ << "// => Local memory zeroing.\n";
 
-    if (localLimits.hasStaticallyAllocatedLimits()) {
-        createLocalRangeZeroing(out, cfg_.getStaticLimitRef(clang::LangAS::opencl_local));
+    // All ranges are filled by the same work-items, so the flattened
+    // work-item index and work-group size are computed only once.
+    if (fusedLocalZeroing_) {
+        out << cfg_.indentation_ << "const size_t "
+            << cfg_.localItemIndexVariable_ << " = "
+            << "(get_local_id(2) * get_local_size(1) + get_local_id(1)) * "
+            << "get_local_size(0) + get_local_id(0);\n"
+            << cfg_.indentation_ << "const size_t "
+            << cfg_.localItemCountVariable_ << " = "
+            << "get_local_size(0) * get_local_size(1) * get_local_size(2);\n";
+    }
+
+    if (writtenArrays.empty()) {
+        if (localLimits.hasStaticallyAllocatedLimits())
+            createLocalRangeZeroing(out, cfg_.getStaticLimitRef(clang::LangAS::opencl_local));
+    } else {
+        // Zero the gaps between arrays that the kernel writes
+        // itself. The arrays are in the same order as the fields.
+        std::string begin = "&" + cfg_.localRecordName_;
+        for (AddressSpaceInfo::const_iterator i = writtenArrays.begin();
+             i != writtenArrays.end(); ++i) {
+            const std::string field = "&" + cfg_.getReferenceToRelocatedVariable(*i);
+            createLocalRangeZeroing(out, begin + ", " + field);
+            begin = "(" + field + " + 1)";
+        }
+        createLocalRangeZeroing(out, begin + ", (&" + cfg_.localRecordName_ + " + 1)");
     }
 
     AddressSpaceLimits::LimitList &dynamicLimits = localLimits.getDynamicLimits();
@@ -1289,8 +1657,10 @@ void WebCLTransformer::createLocalAreaZeroing(
 
     createLocalRangeZeroing(out, cfg_.getNullLimitRef(clang::LangAS::opencl_local));
 
-    out << cfg_.indentation_ << "barrier(CLK_LOCAL_MEM_FENCE);\n";
-    out << cfg_.indentation_ << "// <= Local memory zeroing.\n";
+    if (needsBarrier)
+        out << cfg_.indentation_ << "barrier(CLK_LOCAL_MEM_FENCE);\n";
+    if (!compactOutput_)
+        out << cfg_.indentation_ << "// <= Local memory zeroing.\n";
 }
 
 void WebCLTransformer::replaceWithRelocated(clang::DeclRefExpr *use, clang::VarDecl *decl)
@@ -1306,6 +1676,16 @@ void WebCLTransformer::removeRelocated(clang::VarDecl *decl)
   wclRewriter_.removeText(decl->getSourceRange());
 }
 
+void WebCLTransformer::removeUnused(clang::Decl *decl)
+{
+  // Function definitions end with '}', other declarations with ';'.
+  clang::SourceLocation end = decl->getLocEnd();
+  clang::FunctionDecl *func = llvm::dyn_cast<clang::FunctionDecl>(decl);
+  if (!func || !func->doesThisDeclarationHaveABody())
+    end = wclRewriter_.findLocForNext(end, ';');
+  wclRewriter_.removeText(clang::SourceRange(decl->getLocStart(), end));
+}
+
 std::string WebCLTransformer::getCheckFunctionCall(CheckKind kind, std::string addr, std::string type, unsigned size, AddressSpaceLimits &limits)
 {
   std::stringstream retVal;
@@ -1327,13 +1707,21 @@ std::string WebCLTransformer::getCheckFunctionCall(CheckKind kind, std::string a
 
   retVal << name << "(" << addr << ", " << size;
 
-  if (limits.hasStaticallyAllocatedLimits()) {
-      retVal << ", " << cfg_.getStaticLimitRef(addressSpace, "(" + type + ")");
-  }
+  if (hasLimitTable(limitCount)) {
+      retVal << ", " << cfg_.getLimitTableRef(addressSpace);
+  } else {
+      if (limits.hasStaticallyAllocatedLimits()) {
+          retVal << ", " << cfg_.getStaticLimitRef(addressSpace, "(" + type + ")");
+      }
 
-  for (AddressSpaceLimits::LimitList::iterator i = limits.getDynamicLimits().begin();
-       i != limits.getDynamicLimits().end(); i++) {
-      retVal << ", " << cfg_.getDynamicLimitRef(*i, "(" + type + ")");
+      if (limits.hasRegionLimits()) {
+          retVal << ", " << cfg_.getRegionLimitRef("(" + type + ")");
+      }
+
+      for (AddressSpaceLimits::LimitList::iterator i = limits.getDynamicLimits().begin();
+           i != limits.getDynamicLimits().end(); i++) {
+          retVal << ", " << cfg_.getDynamicLimitRef(*i, "(" + type + ")");
+      }
   }
 
   if (kind == CHECK_CLAMP) {
@@ -1347,38 +1735,41 @@ std::string WebCLTransformer::getCheckFunctionCall(CheckKind kind, std::string a
   return retVal.str();
 }
 
-namespace {
-    struct BaseIndexField {
-	clang::Expr *base;
-	clang::Expr *index;
-	std::string  field;
-  
-	BaseIndexField(clang::Expr *access) : 
-	    base(access), index(NULL) 
-	{
-	    if (clang::MemberExpr *memberExpr = llvm::dyn_cast<clang::MemberExpr>(access)) {
-		base = memberExpr->getBase();
-		field = memberExpr->getMemberNameInfo().getName().getAsString();
-
-	    } else if (clang::ExtVectorElementExpr *vecExpr =
-		llvm::dyn_cast<clang::ExtVectorElementExpr>(access)) {
-		base = vecExpr->getBase();
-		field = vecExpr->getAccessor().getName().str();
-  
-	    } else if (clang::ArraySubscriptExpr *arraySubExpr =
-		llvm::dyn_cast<clang::ArraySubscriptExpr>(access)) {
-		base = arraySubExpr->getBase();
-		index = arraySubExpr->getIdx();
-    
-	    } else if (clang::UnaryOperator *unary = llvm::dyn_cast<clang::UnaryOperator>(access)) {
-		base = unary->getSubExpr();
-	    }
-	}
-	
-    };
+std::string WebCLTransformer::getInlineLimitCheck(std::string addr, std::string type, unsigned size, AddressSpaceLimits &limits)
+{
+    if (!inlineVectorChecks_ || (limits.count() != 1))
+        return "";
+
+    const std::string cast = "(" + type + ")";
+    std::string min;
+    std::string max;
+    if (limits.hasStaticallyAllocatedLimits()) {
+        min = cfg_.getStaticLimitBoundRef(limits.getAddressSpace(), false, cast);
+        max = cfg_.getStaticLimitBoundRef(limits.getAddressSpace(), true, cast);
+    } else if (limits.hasRegionLimits()) {
+        min = cfg_.getRegionLimitBoundRef(false, cast);
+        max = cfg_.getRegionLimitBoundRef(true, cast);
+    } else {
+        const clang::VarDecl *decl = limits.getDynamicLimits().front();
+        min = cfg_.getDynamicLimitBoundRef(decl, false, cast);
+        max = cfg_.getDynamicLimitBoundRef(decl, true, cast);
+    }
+
+    // Same comparison as in the unsigned offset variant of the check
+    // functions. The span test depends only on the limit.
+    std::stringstream bytes;
+    bytes << size << " * sizeof(*" << addr << ")";
+    const std::string span = "((ulong)(" + max + ") - (ulong)(" + min + "))";
+
+    std::stringstream retVal;
+    retVal << "(" << bytes.str() << " <= " << span << ")"
+           << " & "
+           << "(((ulong)(" << addr << ") - (ulong)(" << min << ")) <= (" << span << " - " << bytes.str() << "))";
+    return retVal.str();
 }
 
-std::string WebCLTransformer::getClampFunctionExpression(clang::Expr *access, unsigned size, AddressSpaceLimits &limits)
+std::string WebCLTransformer::getClampFunctionExpression(clang::Expr *access, unsigned size, AddressSpaceLimits &limits,
+                                                          const std::string &checkedPointer)
 {
     BaseIndexField     bif(access);
     clang::SourceRange baseRange = clang::SourceRange(bif.base->getLocStart(), bif.base->getLocEnd());
@@ -1397,7 +1788,11 @@ std::string WebCLTransformer::getClampFunctionExpression(clang::Expr *access, un
     std::string macro = getCheckFunctionCall(CHECK_CLAMP, memAddress.str(), bif.base->getType().getAsString(), size, limits);
 
     std::stringstream retVal;
-    retVal << "(*(" << macro  << "))";
+    retVal << "(*(";
+    if (!checkedPointer.empty()) {
+	retVal << checkedPointer << " = ";
+    }
+    retVal << macro  << "))";
     if (!bif.field.empty()) {
 	retVal << "." << bif.field;
     }
@@ -1405,9 +1800,10 @@ std::string WebCLTransformer::getClampFunctionExpression(clang::Expr *access, un
     return retVal.str();
 }
 
-void WebCLTransformer::addMemoryAccessCheck(clang::Expr *access, unsigned size, AddressSpaceLimits &limits)
+void WebCLTransformer::addMemoryAccessCheck(clang::Expr *access, unsigned size, AddressSpaceLimits &limits,
+                                            const std::string &checkedPointer)
 {
-  std::string retVal = getClampFunctionExpression(access, size, limits);
+  std::string retVal = getClampFunctionExpression(access, size, limits, checkedPointer);
   
   DEBUG(
     std::cerr << "Creating memcheck for: " << original
@@ -1422,6 +1818,126 @@ void WebCLTransformer::addMemoryAccessCheck(clang::Expr *access, unsigned size,
   DEBUG( std::cerr << "============================\n\n"; );
 }
 
+void WebCLTransformer::addArrayIndexClamp(clang::ArraySubscriptExpr *access, unsigned long long size)
+{
+    const std::string base = wclRewriter_.getTransformedText(access->getBase()->getSourceRange());
+    const std::string index = wclRewriter_.getTransformedText(access->getIdx()->getSourceRange());
+    const unsigned long long last = size - 1;
+
+    std::stringstream retVal;
+    retVal << "(" << base << ")[";
+    if ((size & last) == 0) {
+        retVal << "(uint)(" << index << ") & " << last << "u";
+    } else {
+        retVal << "min((uint)(" << index << "), " << last << "u)";
+    }
+    retVal << "]";
+
+    wclRewriter_.replaceText(access->getSourceRange(), retVal.str());
+}
+
+void WebCLTransformer::addArrayPadding(const clang::VarDecl *decl, unsigned long long size)
+{
+    paddedArrays_[decl] = size;
+}
+
+unsigned long long WebCLTransformer::getPaddedArraySize(const clang::VarDecl *decl) const
+{
+    PaddedArrayMap::const_iterator i = paddedArrays_.find(decl);
+    return (i != paddedArrays_.end()) ? i->second : 0;
+}
+
+std::string WebCLTransformer::getCheckedPointerDeclaration(clang::Expr *access, const std::string &name)
+{
+    BaseIndexField bif(access);
+    std::string declaration;
+    llvm::raw_string_ostream stream(declaration);
+    clang::PrintingPolicy policy(instance_.getLangOpts());
+    bif.base->getType().getUnqualifiedType().print(stream, policy, name);
+    return stream.str();
+}
+
+std::string WebCLTransformer::addCheckedPointer(const clang::FunctionDecl *func, clang::Expr *access)
+{
+    const std::string name = cfg_.getNameOfCheckedPointer(checkedPointerCount_++);
+    std::ostream &out = functionPrologue(functionPrologues_, func);
+    out << "\n" << getCheckedPointerDeclaration(access, name) << ";\n";
+    return name;
+}
+
+std::string WebCLTransformer::addCheckedRange(const clang::FunctionDecl *func,
+                                              clang::CompoundStmt *block, clang::Stmt *stmt,
+                                              clang::Expr *access, clang::Expr *common,
+                                              int offset, unsigned count,
+                                              AddressSpaceLimits &limits)
+{
+    BaseIndexField bif(access);
+    std::stringstream address;
+    address << "(" << wclRewriter_.getTransformedText(bif.base->getSourceRange()) << ")";
+    if (common) {
+        address << "+(" << wclRewriter_.getTransformedText(common->getSourceRange()) << ")";
+    }
+    if (offset) {
+        address << "+(" << offset << ")";
+    }
+
+    const std::string name = cfg_.getNameOfCheckedPointer(checkedPointerCount_++);
+    std::stringstream code;
+    code << getCheckedPointerDeclaration(access, name) << " = "
+         << getCheckFunctionCall(CHECK_CLAMP, address.str(), bif.base->getType().getAsString(), count, limits)
+         << ";";
+    insertBeforeStatement(func, block, stmt, code.str());
+    return name;
+}
+
+void WebCLTransformer::addCheckedMemoryAccess(clang::Expr *access, const std::string &checkedPointer,
+                                              int offset)
+{
+    BaseIndexField bif(access);
+    std::stringstream retVal;
+    if (offset) {
+        retVal << "(*((" << checkedPointer << ")+" << offset << "))";
+    } else {
+        retVal << "(*(" << checkedPointer << "))";
+    }
+    if (!bif.field.empty()) {
+        retVal << "." << bif.field;
+    }
+    wclRewriter_.replaceText(access->getSourceRange(), retVal.str());
+}
+
+void WebCLTransformer::insertBeforeStatement(const clang::FunctionDecl *func,
+                                             clang::CompoundStmt *block, clang::Stmt *stmt,
+                                             const std::string &code)
+{
+    clang::Stmt *previous = NULL;
+    for (clang::CompoundStmt::body_iterator i = block->body_begin();
+         (i != block->body_end()) && (*i != stmt); ++i) {
+        previous = *i;
+    }
+
+    clang::SourceLocation addLoc;
+    if (!previous) {
+        if (block == func->getBody()) {
+            functionPrologue(functionPrologues_, func) << "\n" << code << "\n";
+            return;
+        }
+        addLoc = block->getLBracLoc();
+    } else {
+        // Add code after the token that terminates the previous
+        // statement. Blocks end with '}', other statements with ';'.
+        addLoc = previous->getLocEnd();
+        const char *lastChar = instance_.getSourceManager().getCharacterData(addLoc);
+        if (llvm::isa<clang::Expr>(previous) || llvm::isa<clang::DeclStmt>(previous) ||
+            (*lastChar != '}')) {
+            addLoc = wclRewriter_.findLocForNext(addLoc, ';');
+        }
+    }
+
+    clang::SourceRange addRange(addLoc, addLoc);
+    wclRewriter_.replaceText(addRange, wclRewriter_.getTransformedText(addRange) + " " + code);
+}
+
 void WebCLTransformer::addRelocationInitializerFromFunctionArg(clang::ParmVarDecl *parmDecl)
 {
   const clang::FunctionDecl *parent = llvm::dyn_cast<const clang::FunctionDecl>(parmDecl->getParentFunctionOrMethod());
@@ -1451,6 +1967,17 @@ void WebCLTransformer::addRelocationInitializer(clang::VarDecl *decl)
 
 }
 
+void WebCLTransformer::addZeroInitializer(clang::VarDecl *decl)
+{
+  clang::SourceLocation addLoc = wclRewriter_.findLocForNext(decl->getLocEnd(), ';');
+  clang::SourceRange replaceRange(addLoc, addLoc);
+  std::stringstream inits;
+  inits << wclRewriter_.getTransformedText(replaceRange) << ";";
+  inits << decl->getNameAsString() << " = ("
+        << decl->getType().getUnqualifiedType().getAsString() << ")0;";
+  wclRewriter_.replaceText(replaceRange, inits.str());
+}
+
 void WebCLTransformer::moveToModulePrologue(clang::NamedDecl *decl)
 {
     // set typeName if we should make sure that this declaration name is not used multiple times
@@ -1511,7 +2038,7 @@ void WebCLTransformer::addMinimumRequiredContinuousAreaLimit(unsigned addressSpa
 
 void WebCLTransformer::addRecordParameter(clang::FunctionDecl *decl)
 {
-    std::string parameter = cfg_.addressSpaceRecordType_ + " *" + cfg_.addressSpaceRecordName_;
+    std::string parameter = getAddressSpaceRecordPointer();
 
     if (decl->getNumParams() > 0) {
       clang::SourceLocation addLoc = wclRewriter_.findLocForNext(decl->getLocStart(), '(');
@@ -1549,6 +2076,52 @@ void WebCLTransformer::addSizeParameter(clang::ParmVarDecl *decl)
         replacement);
 }
 
+void WebCLTransformer::addMaskParameter(clang::ParmVarDecl *decl)
+{
+    const std::string parameter =
+        cfg_.sizeParameterType_ + " " + cfg_.getNameOfMaskParameter(decl->getName());
+    const std::string replacement =
+        wclRewriter_.getOriginalText(decl->getSourceRange()) + ", " + parameter;
+    wclRewriter_.replaceText(
+        decl->getSourceRange(),
+        replacement);
+    paddedBuffers_.insert(decl);
+}
+
+void WebCLTransformer::addConstantRegionParameters(clang::FunctionDecl *kernel)
+{
+    assert(kernel->getNumParams() && "Kernel without constant memory object parameters.");
+
+    // Append after the last parameter, which may already have a size
+    // parameter of its own.
+    clang::ParmVarDecl *last = kernel->getParamDecl(kernel->getNumParams() - 1);
+    const std::string parameters =
+        "__" + cfg_.constantAddressSpace_ + " uchar *" + cfg_.constantRegionParameter_ + ", " +
+        cfg_.sizeParameterType_ + " " + cfg_.constantRegionSizeParameter_;
+    const std::string replacement =
+        wclRewriter_.getTransformedText(last->getSourceRange()) + ", " + parameters;
+    wclRewriter_.replaceText(
+        last->getSourceRange(),
+        replacement);
+    constantRegionKernels_.insert(kernel);
+}
+
+bool WebCLTransformer::isPaddedBuffer(const clang::ParmVarDecl *decl) const
+{
+    return paddedBuffers_.count(decl) > 0;
+}
+
+void WebCLTransformer::addMaskedMemoryAccess(clang::ArraySubscriptExpr *access, clang::ParmVarDecl *decl)
+{
+    const std::string base = wclRewriter_.getTransformedText(access->getBase()->getSourceRange());
+    const std::string index = wclRewriter_.getTransformedText(access->getIdx()->getSourceRange());
+
+    std::stringstream retVal;
+    retVal << "(" << base << ")[(" << index << ") & "
+           << cfg_.getNameOfMaskParameter(decl->getName()) << "]";
+    wclRewriter_.replaceText(access->getSourceRange(), retVal.str());
+}
+
 bool WebCLTransformer::rewritePrologue()
 {
     std::ostringstream out;
@@ -1600,7 +2173,10 @@ void WebCLTransformer::emitVarDeclToStruct(std::ostream &out, const clang::VarDe
       clang::QualType fixedType = clang::QualType(unqualArray.getTypePtr(), qualifiers);
       const clang::ConstantArrayType *constArr = llvm::dyn_cast<clang::ConstantArrayType>(fixedType.getTypePtr()->getAsArrayTypeUnsafe());
       assert(constArr && "OpenCL can't have non-constant arrays.");
-      out << constArr->getElementType().getAsString() << " " << name << "[" << constArr->getSize().getZExtValue() << "]";
+      unsigned long long size = getPaddedArraySize(decl);
+      if (!size)
+          size = constArr->getSize().getZExtValue();
+      out << constArr->getElementType().getAsString() << " " << name << "[" << size << "]";
 
     } else {
       clang::QualType::print(typePtr, qualifiers, stream, policy, name);
@@ -1616,6 +2192,125 @@ void WebCLTransformer::emitGeneralCode(std::ostream &out)
     out << "\n" << generalClContents << "\n";
 }
 
+namespace {
+
+    bool isIdentifierCharacter(char c)
+    {
+        return std::isalnum(static_cast<unsigned char>(c)) || (c == '_');
+    }
+
+    /// \return Whether the code contains the name as a complete
+    /// identifier.
+    bool refersTo(const std::string &code, const std::string &name)
+    {
+        for (std::string::size_type i = code.find(name);
+             i != std::string::npos; i = code.find(name, i + 1)) {
+            const std::string::size_type end = i + name.size();
+            if (((i == 0) || !isIdentifierCharacter(code[i - 1])) &&
+                ((end == code.size()) || !isIdentifierCharacter(code[end]))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Definition or preprocessor directive of general.cl.
+    struct GeneralItem
+    {
+        /// Text of the item including continuation lines.
+        std::string text;
+        /// Name of the defined macro, type or variable. Empty for
+        /// conditional and pragma directives.
+        std::string name;
+        /// Index of the enclosing conditional block or -1. Blocks
+        /// of general.cl aren't nested.
+        int block;
+    };
+
+    /// \return Name defined by a macro definition, or a typedef or
+    /// variable declaration.
+    std::string getDefinedName(const std::string &text)
+    {
+        std::string::size_type end;
+        if (!text.compare(0, 7, "#define")) {
+            std::string::size_type begin = text.find_first_not_of(" \t", 7);
+            end = begin;
+            while ((end < text.size()) && isIdentifierCharacter(text[end]))
+                ++end;
+            return text.substr(begin, end - begin);
+        }
+
+        end = text.find_first_of("=;");
+        end = text.find_last_not_of(" \t", end - 1) + 1;
+        std::string::size_type begin = end;
+        while ((begin > 0) && isIdentifierCharacter(text[begin - 1]))
+            --begin;
+        return text.substr(begin, end - begin);
+    }
+}
+
+void WebCLTransformer::emitGeneralCode(std::ostream &out, const std::string &code)
+{
+    const char *buffer = reinterpret_cast<const char*>(general_endlfix_cl);
+    std::istringstream general(std::string(buffer, general_endlfix_cl_len));
+
+    std::vector<GeneralItem> items;
+    int block = -1;
+    int blockCount = 0;
+    std::string line;
+    while (std::getline(general, line)) {
+        const std::string::size_type first = line.find_first_not_of(" \t");
+        if ((first == std::string::npos) || !line.compare(first, 2, "//"))
+            continue;
+
+        GeneralItem item;
+        item.text = line;
+        if (!line.compare(0, 3, "#if")) {
+            block = blockCount++;
+        } else if (line.compare(0, 7, "#define") && (line[0] == '#')) {
+            // #else, #endif and #pragma
+        } else {
+            while (!line.empty() && (line[line.size() - 1] == '\\') &&
+                   std::getline(general, line))
+                item.text += "\n" + line;
+            item.name = getDefinedName(item.text);
+        }
+        item.block = block;
+        items.push_back(item);
+        if (!line.compare(0, 6, "#endif"))
+            block = -1;
+    }
+
+    // Definitions may refer to each other, so keep adding the text of
+    // used definitions until no more definitions become used.
+    std::string references = code;
+    std::vector<bool> used(items.size(), false);
+    std::vector<bool> usedBlocks(blockCount, false);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (unsigned i = 0; i < items.size(); ++i) {
+            const GeneralItem &item = items[i];
+            if (used[i] || item.name.empty() || !refersTo(references, item.name))
+                continue;
+            used[i] = true;
+            if (item.block >= 0)
+                usedBlocks[item.block] = true;
+            references += "\n" + item.text;
+            changed = true;
+        }
+    }
+
+    out << "\n";
+    for (unsigned i = 0; i < items.size(); ++i) {
+        const GeneralItem &item = items[i];
+        const bool isDirective = item.name.empty();
+        if ((isDirective && ((item.block < 0) || usedBlocks[item.block])) || used[i])
+            out << item.text << "\n";
+    }
+    out << "\n";
+}
+
 void WebCLTransformer::emitLimitFunctions(std::ostream &out)
 {
     for (RequiredFunctionSet::iterator i = usedClampFunctions_.begin();
@@ -1633,24 +2328,78 @@ std::string WebCLTransformer::getWclAddrCheckFunctionDefinition(ClampFunctionKey
     std::stringstream limitCheckCallArgs;
     limitCheckDeclArgs << clamp.type << "addr, unsigned size";
     limitCheckCallArgs << "addr, size";
-    for (unsigned i = 0; i < clamp.limitCount; i++) {
-	limitCheckDeclArgs << ", " << clamp.type << " min" << i << ", " << clamp.type << " max" << i;
-	limitCheckCallArgs << ", min" << i << ", max" << i;
+    const bool hasTable = hasLimitTable(clamp.limitCount);
+    if (hasTable) {
+        limitCheckDeclArgs << ", const ulong *table";
+        limitCheckCallArgs << ", table";
+    } else {
+        for (unsigned i = 0; i < clamp.limitCount; i++) {
+            limitCheckDeclArgs << ", " << clamp.type << " min" << i << ", " << clamp.type << " max" << i;
+            limitCheckCallArgs << ", min" << i << ", max" << i;
+        }
     }
 
     retVal << "bool " << cfg_.getNameOfLimitCheckFunction(clamp.aSpaceNum, clamp.limitCount, clamp.type)
            << "(" << limitCheckDeclArgs.str() << ")\n"
-           << "{\n"
-           << cfg_.getIndentation(1) << "  return 0";
-
-    // at least one of the limits must match
-    for (unsigned i = 0; i < clamp.limitCount; i++) {
-	retVal << "\n" << cfg_.getIndentation(2) << "|| "
-	       << "( "
-	       << "((addr) >= (min" << i << "))"
-	       << " && "
-	       << "((addr + size - 1) <= " << cfg_.getNameOfLimitMacro() << "(" << clamp.type << ", max" << i << "))"
-	       << " )";
+           << "{\n";
+
+    if (hasTable) {
+        // Find the last limit that starts at or below the address
+        // with a branchless binary search over the sorted table. The
+        // first step splits the table into two power of two sized
+        // halves that overlap when the limit count isn't a power of
+        // two.
+        unsigned step = 1;
+        while ((step * 2) <= clamp.limitCount)
+            step *= 2;
+        const unsigned rest = clamp.limitCount - step;
+
+        retVal << cfg_.getIndentation(1) << "const ulong first = (ulong)(addr);\n"
+               << cfg_.getIndentation(1) << "const ulong last = first + (ulong)size * sizeof(*addr);\n"
+               << cfg_.getIndentation(1) << "uint i = ";
+        if (rest) {
+            retVal << "(table[" << (2 * rest) << "] <= first) ? " << rest << " : 0;\n";
+        } else {
+            retVal << "0;\n";
+        }
+        for (step /= 2; step > 0; step /= 2) {
+            retVal << cfg_.getIndentation(1) << "i = (table[2 * (i + " << step << ")] <= first) ? (i + "
+                   << step << ") : i;\n";
+        }
+        retVal << cfg_.getIndentation(1) << "return (table[2 * i] <= first) & (first <= last) & "
+               << "(last <= table[2 * i + 1])";
+    } else if (unsignedOffsetChecks_) {
+        // Compare byte offsets from the start of each limit as
+        // unsigned values so that addresses below the limit wrap
+        // around and fail the same comparison as addresses above
+        // it. The spans depend only on the limits and can be hoisted
+        // out of loops after inlining.
+        retVal << cfg_.getIndentation(1) << "const ulong bytes = (ulong)size * sizeof(*addr);\n";
+        for (unsigned i = 0; i < clamp.limitCount; i++) {
+            retVal << cfg_.getIndentation(1) << "const ulong span" << i
+                   << " = (ulong)(max" << i << ") - (ulong)(min" << i << ");\n";
+        }
+        retVal << cfg_.getIndentation(1) << "return 0";
+        for (unsigned i = 0; i < clamp.limitCount; i++) {
+            retVal << "\n" << cfg_.getIndentation(2) << "| "
+                   << "( "
+                   << "(bytes <= span" << i << ")"
+                   << " & "
+                   << "(((ulong)(addr) - (ulong)(min" << i << ")) <= (span" << i << " - bytes))"
+                   << " )";
+        }
+    } else {
+        retVal << cfg_.getIndentation(1) << "  return 0";
+
+        // at least one of the limits must match
+        for (unsigned i = 0; i < clamp.limitCount; i++) {
+            retVal << "\n" << cfg_.getIndentation(2) << "|| "
+                   << "( "
+                   << "((addr) >= (min" << i << "))"
+                   << " && "
+                   << "((addr + size - 1) <= " << cfg_.getNameOfLimitMacro() << "(" << clamp.type << ", max" << i << "))"
+                   << " )";
+        }
     }
     retVal << ";\n"
            << "}\n";
@@ -1673,9 +2422,26 @@ void WebCLTransformer::emitPrologue(std::ostream &out)
 {
     out << preModulePrologue_.str();
     out << modulePrologue_.str();
-    emitGeneralCode(out);
-    emitLimitFunctions(out);
-    out << afterLimitFunctions_.str();
+    if (!compactOutput_) {
+        emitGeneralCode(out);
+        emitLimitFunctions(out);
+        out << afterLimitFunctions_.str();
+        return;
+    }
+
+    std::ostringstream functions;
+    emitLimitFunctions(functions);
+    functions << afterLimitFunctions_.str();
+
+    clang::SourceManager &manager = instance_.getSourceManager();
+    clang::FileID file = manager.getMainFileID();
+    clang::SourceRange program(
+        manager.getLocForStartOfFile(file), manager.getLocForEndOfFile(file));
+    emitGeneralCode(
+        out,
+        preModulePrologue_.str() + modulePrologue_.str() + functions.str() +
+        wclRewriter_.getTransformedText(program));
+    out << functions.str();
 }
 
 void WebCLTransformer::emitTypeNullInitialization(
@@ -1714,47 +2480,83 @@ void WebCLTransformer::changeFunctionCallee(clang::CallExpr *expr,
     wclRewriter_.replaceText(callee->getSourceRange(), newName);
 }
 
-bool WebCLTransformer::wrapFunctionCall(std::string wrapperName, clang::CallExpr *expr, WebCLKernelHandler &kernelHandler)
+WebCLTransformer::FunctionCallWrapper *WebCLTransformer::findCallWrapper(clang::CallExpr *expr)
 {
-    bool handled = false;
-    
-    for (FunctionCallWrapperList::iterator wrapperIt = functionWrappers_.begin();
-         !handled && wrapperIt != functionWrappers_.end();
+    const clang::FunctionDecl *callee = expr->getDirectCallee();
+    if (const clang::IdentifierInfo *identifier = callee->getIdentifier()) {
+        FunctionCallWrapperIndex::iterator named = namedWrappers_.find(identifier->getName());
+        if (named != namedWrappers_.end()) {
+            FunctionCallWrapperList &wrappers = named->second;
+            for (FunctionCallWrapperList::iterator wrapperIt = wrappers.begin();
+                 wrapperIt != wrappers.end();
+                 ++wrapperIt) {
+                if ((*wrapperIt)->getNumArgs() == expr->getNumArgs())
+                    return *wrapperIt;
+            }
+        }
+    }
+
+    for (FunctionCallWrapperList::iterator wrapperIt = unnamedWrappers_.begin();
+         wrapperIt != unnamedWrappers_.end();
          ++wrapperIt) {
+        if ((*wrapperIt)->matchesCallExpr(instance_, expr))
+            return *wrapperIt;
+    }
 
-        if ((*wrapperIt)->matchesCallExpr(instance_, expr)) {
-            WrappedFunction result =
-                (*wrapperIt)->wrapFunction(
-                    *this, instance_,
-                    expr,
-                    ExprVector(expr->getArgs(), expr->getArgs() + expr->getNumArgs()),
-                    kernelHandler,
-                    wclRewriter_);
+    return 0;
+}
 
-            if (result.doWrap_) {
-                afterLimitFunctions_ << wrappedDeclaration(instance_, result.returnTypeStr_, expr, wrapperName, result.addAddressSpaceRecordArg_) << "\n";
+bool WebCLTransformer::isWrappedCall(clang::CallExpr *expr)
+{
+    return findCallWrapper(expr) != 0;
+}
 
-                afterLimitFunctions_ << "{\n" << result.body_ << "}\n";
+bool WebCLTransformer::wrapFunctionCall(std::string &wrapperName, clang::CallExpr *expr, WebCLKernelHandler &kernelHandler)
+{
+    FunctionCallWrapper *callWrapper = findCallWrapper(expr);
+    if (!callWrapper)
+        return false;
 
-                changeFunctionCallee(expr, wrapperName);
-                if (result.addAddressSpaceRecordArg_) {
-                  addRecordArgument(expr);
-                }
-            }
-	
-            handled = true;
+    WrappedFunction result =
+        callWrapper->wrapFunction(
+            *this, instance_,
+            expr,
+            ExprVector(expr->getArgs(), expr->getArgs() + expr->getNumArgs()),
+            kernelHandler,
+            wclRewriter_);
+
+    if (result.doWrap_) {
+        // Wrappers with identical signature and body are
+        // emitted only once and shared by all call sites.
+        const std::string key =
+            wrappedDeclaration(instance_, result.returnTypeStr_, expr, "", result.addAddressSpaceRecordArg_) +
+            "\n" + result.body_;
+        WrapperFunctionMap::iterator wrapper = wrapperFunctions_.find(key);
+        if (wrapper != wrapperFunctions_.end()) {
+            wrapperName = wrapper->second;
+        } else {
+            wrapperFunctions_[key] = wrapperName;
+            afterLimitFunctions_ << wrappedDeclaration(instance_, result.returnTypeStr_, expr, wrapperName, result.addAddressSpaceRecordArg_) << "\n";
+
+            afterLimitFunctions_ << "{\n" << result.body_ << "}\n";
+        }
+
+        changeFunctionCallee(expr, wrapperName);
+        if (result.addAddressSpaceRecordArg_) {
+          addRecordArgument(expr);
         }
     }
 
-    return handled;
+    return true;
 }
 
 bool WebCLTransformer::wrapVariableDeclaration(clang::VarDecl *varDecl, WebCLKernelHandler &kernelHandler)
 {
     bool handled = false;
 
-    for (FunctionCallWrapperList::iterator wrapperIt = functionWrappers_.begin();
-         !handled && wrapperIt != functionWrappers_.end();
+    // named wrappers never match declarations
+    for (FunctionCallWrapperList::iterator wrapperIt = unnamedWrappers_.begin();
+         !handled && wrapperIt != unnamedWrappers_.end();
          ++wrapperIt) {
         if ((*wrapperIt)->matchesVarDecl(instance_, varDecl)) {
             (*wrapperIt)->wrapDeclaration(
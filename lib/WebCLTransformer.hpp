@@ -29,6 +29,8 @@
 #include "WebCLReporter.hpp"
 #include "WebCLRewriter.hpp"
 
+#include "llvm/ADT/StringMap.h"
+
 #include <map>
 #include <set>
 #include <utility>
@@ -37,10 +39,13 @@
 namespace clang {
     class ArraySubscriptExpr;
     class CallExpr;
+    class CompoundStmt;
     class Decl;
     class DeclStmt;
     class Expr;
+    class FunctionDecl;
     class ParmVarDecl;
+    class Stmt;
     class Rewriter; 
     class TypedefDecl;
     class VarDecl;
@@ -78,12 +83,30 @@ public:
     /// Create private address space structure.
     /// \see createAddressSpaceTypedef
     void createPrivateAddressSpaceTypedef(AddressSpaceInfo &as);
+    /// Lets a relocated variable share storage with the variables of
+    /// other functions that use the same slot. The variables of each
+    /// function are grouped into a structure and the structures of a
+    /// slot are placed into a union:
+    ///
+    /// typedef struct {
+    ///     union {
+    ///         struct { int _wcl_a; } _wcl_foo;
+    ///         struct { float _wcl_b; } _wcl_bar;
+    ///     } _wcl_0slot;
+    /// } _WclPrivates;
+    ///
+    /// Must be called before address space structures are created.
+    void addSharedSlot(const clang::VarDecl *decl, unsigned slot, const std::string &function);
     /// Create local address space structure.
     /// \see createAddressSpaceTypedef
     void createLocalAddressSpaceTypedef(AddressSpaceInfo &as);
     /// Create constant address space structure.
     /// \see createAddressSpaceTypedef
     void createConstantAddressSpaceTypedef(AddressSpaceInfo &as);
+    /// \return Size of address space structure in bytes. Padding
+    /// that the alignment attribute of the structure may add isn't
+    /// included.
+    unsigned long long getAddressSpaceSize(AddressSpaceInfo &as);
 
     /// Replace a reference to a relocated variable with a reference
     /// to the corresponding address space structure field.
@@ -92,6 +115,9 @@ public:
     /// example, the variable could have been relocated to an address
     /// space structure and initializations don't depend on it.
     void removeRelocated(clang::VarDecl *decl);
+    /// Remove a function or variable declaration that isn't used by
+    /// any kernel, including the semicolon ending the declaration.
+    void removeUnused(clang::Decl *decl);
 
     /// Create a limits structure that contains the begin and end
     /// addresses of each memory object (in the given address space)
@@ -142,12 +168,22 @@ public:
     /// space is excluded.
     void createAddressSpaceLimitsInitializer(
         std::ostream &out, clang::FunctionDecl *kernel, AddressSpaceLimits &limits);
+    /// Assigns the address space specific limits and the fallback
+    /// area to fields of the main allocation structure.
+    void createAddressSpaceLimitsAssignment(
+        std::ostream &out, clang::FunctionDecl *kernel, AddressSpaceLimits &limits,
+        const std::string &type, const std::string &field, const std::string &nullField);
+    /// Zeroes the private variables of the main allocation structure
+    /// except for the given ones.
+    void createPrivateAreaZeroing(
+        std::ostream &out, const AddressSpaceInfo &writtenPrivates);
     /// Creates an allocation with initialization for the instance of
-    /// the main allocation structure.
+    /// the main allocation structure. Given private variables, which
+    /// the kernel writes before reading, aren't zero initialized.
     void createProgramAllocationsAllocation(
         clang::FunctionDecl *kernelFunc, AddressSpaceLimits &globalLimits,
         AddressSpaceLimits &constantLimits, AddressSpaceLimits &localLimits,
-        AddressSpaceInfo &privateAs);
+        AddressSpaceInfo &privateAs, const AddressSpaceInfo &writtenPrivates);
 
     /// Creates and initializes a variable declaration that holds
     /// enough space for the largest memory access in the given
@@ -175,14 +211,85 @@ public:
 
     /// \brief Zero a single local memory range.
     void createLocalRangeZeroing(std::ostream &out, const std::string &arguments);
-    /// \brief Zero all local memory ranges.
+    /// \brief Zero all local memory ranges except the given relocated
+    /// arrays, which the kernel writes before reading. The barrier
+    /// after zeroing can be left out if the kernel doesn't access
+    /// local memory before its own barrier.
     void createLocalAreaZeroing(clang::FunctionDecl *kernelFunc,
-                                AddressSpaceLimits &localLimits);
+                                AddressSpaceLimits &localLimits,
+                                const AddressSpaceInfo &writtenArrays,
+                                bool needsBarrier);
 
     /// Replaces memory access with a checked access. If the access
     /// doesn't fall within limits of any given disjoint memory areas,
     /// the fallback area (null pointer) is accessed instead.
-    void addMemoryAccessCheck(clang::Expr *access, unsigned size, AddressSpaceLimits &limits);
+    ///
+    /// If a checked pointer variable is given, the checked address is
+    /// also stored to it so that later identical accesses can reuse
+    /// it:
+    ///
+    /// a[i] = 1;
+    /// ->
+    /// (*(_wcl_checked_ptr_0 = _wcl_addr_clamp_global_1((a)+(i), ...))) = 1;
+    void addMemoryAccessCheck(clang::Expr *access, unsigned size, AddressSpaceLimits &limits,
+                              const std::string &checkedPointer = "");
+
+    /// Replaces the index of a fixed size array access with an index
+    /// that is clamped to the array bounds. Indices of arrays whose
+    /// size is a power of two are masked:
+    ///
+    /// int a[3], b[4];
+    /// a[i] + b[i]
+    /// ->
+    /// (a)[min((uint)(i), 2u)] + (b)[(uint)(i) & 3u]
+    void addArrayIndexClamp(clang::ArraySubscriptExpr *access, unsigned long long size);
+
+    /// Pads a fixed size array to the given number of elements when
+    /// it is relocated to an address space structure:
+    ///
+    /// __local int a[6]; -> typedef struct { int _wcl_a[8]; } _WclLocals;
+    void addArrayPadding(const clang::VarDecl *decl, unsigned long long size);
+    /// \return Padded number of elements of a fixed size array or
+    /// zero if the array isn't padded.
+    unsigned long long getPaddedArraySize(const clang::VarDecl *decl) const;
+
+    /// Declares a variable for storing the checked address of the
+    /// given memory access at the start of the function.
+    ///
+    /// \return Name of the checked pointer variable.
+    ///
+    /// \see addMemoryAccessCheck
+    /// \see addCheckedMemoryAccess
+    std::string addCheckedPointer(const clang::FunctionDecl *func, clang::Expr *access);
+
+    /// Checks a range of elements just before the given statement of
+    /// a block and stores the checked pointer to a new variable. The
+    /// range starts at offset elements from base[common] and contains
+    /// count elements:
+    ///
+    /// x = a[i] + a[i + 1];
+    /// ->
+    /// __global int *_wcl_checked_ptr_0 = _wcl_addr_clamp_global_1((a)+(i), 2, ...);
+    /// x = (*(_wcl_checked_ptr_0)) + (*((_wcl_checked_ptr_0)+1));
+    ///
+    /// \return Name of the checked pointer variable.
+    ///
+    /// \see addCheckedMemoryAccess
+    std::string addCheckedRange(const clang::FunctionDecl *func,
+                                clang::CompoundStmt *block, clang::Stmt *stmt,
+                                clang::Expr *access, clang::Expr *common,
+                                int offset, unsigned count,
+                                AddressSpaceLimits &limits);
+
+    /// Replaces memory access with an access through a pointer that
+    /// has already been checked. The offset tells how many elements
+    /// the access is located after the checked pointer:
+    ///
+    /// x = a[i];
+    /// ->
+    /// x = (*(_wcl_checked_ptr_0));
+    void addCheckedMemoryAccess(clang::Expr *access, const std::string &checkedPointer,
+                                int offset = 0);
 
     /// Adds an initialization row to start of function if relocated
     /// variable was a function argument.
@@ -212,6 +319,15 @@ public:
     /// foo) away afterwards.
     void addRelocationInitializer(clang::VarDecl *decl);
 
+    /// Initializes an uninitialized scalar or vector variable that
+    /// isn't relocated:
+    ///
+    /// float4 foo;
+    /// ->
+    /// float4 foo;
+    /// foo = (float4)0;
+    void addZeroInitializer(clang::VarDecl *decl);
+
     /// Defines a macro that tells what is the largest memory access
     /// in the given address space. The macro defines this size as
     /// bytes, not as bits.
@@ -250,6 +366,22 @@ public:
     /// Modify kernel parameter declarations:
     /// kernel(a, array, b) -> kernel(a, array, array_size, b)
     void addSizeParameter(clang::ParmVarDecl *decl);
+    /// Modify kernel parameter declarations of memory objects that
+    /// are padded to a power of two number of elements:
+    /// kernel(a, array, b) -> kernel(a, array, array_mask, b)
+    void addMaskParameter(clang::ParmVarDecl *decl);
+    /// \return Whether the memory object parameter has a mask
+    /// parameter instead of a size parameter.
+    bool isPaddedBuffer(const clang::ParmVarDecl *decl) const;
+    /// Modify kernel parameter declarations of kernels whose constant
+    /// memory objects are bound into the constant region:
+    /// kernel(a, b) -> kernel(a, b, _wcl_constant_region, _wcl_constant_region_size)
+    void addConstantRegionParameters(clang::FunctionDecl *kernel);
+    /// Replaces the index of an access through a padded memory object
+    /// parameter with an index that is masked to the padded size:
+    ///
+    /// array[i] -> (array)[(i) & _wcl_array_mask]
+    void addMaskedMemoryAccess(clang::ArraySubscriptExpr *access, clang::ParmVarDecl *decl);
 
     /// Modify a function call to call a function of another name
     void changeFunctionCallee(clang::CallExpr *expr, std::string newName);
@@ -269,7 +401,13 @@ public:
     /// of its integer constant expression and then reconstructed by generating
     /// an expression that builds the desired value by using the related macro
     /// definitions and the bitwise or operator.
-    bool wrapFunctionCall(std::string wrapperName, clang::CallExpr *expr, WebCLKernelHandler &kernelHandler);
+    /// Call sites whose wrappers would have identical declarations and
+    /// bodies share the first one; wrapperName is then updated to the
+    /// name of the shared wrapper.
+    bool wrapFunctionCall(std::string &wrapperName, clang::CallExpr *expr, WebCLKernelHandler &kernelHandler);
+    /// \return Whether wrapFunctionCall may replace the call with a
+    /// wrapper function call.
+    bool isWrappedCall(clang::CallExpr *expr);
 
     /// Same, but for variable declarations. For variable declarations no helper functions
     /// are currently generated, so it doesn't use a name argument for that.
@@ -287,6 +425,11 @@ public:
     ///
     /// e.g. _WCL_ADDR_global_1(__global int *, addr, _wcl_allocs->gl.array_min, _wcl_allocs->gl.array_max, _wcl_allocs->gn)
     std::string getCheckFunctionCall(CheckKind kind, std::string addr, std::string type, unsigned size, AddressSpaceLimits &limits);
+    /// \return A condition that checks an access of size elements at
+    /// addr against the only limit of an address space by comparing
+    /// unsigned byte offsets, or an empty string if inline checks
+    /// aren't enabled or the address space has several limits.
+    std::string getInlineLimitCheck(std::string addr, std::string type, unsigned size, AddressSpaceLimits &limits);
 
 private:
 
@@ -309,7 +452,7 @@ private:
 
     /// Stream for inserting code at the beginning of each kernel or
     /// helper function.
-    typedef std::map< const clang::FunctionDecl*, std::stringstream* > FunctionPrologueMap;
+    typedef std::map< const clang::FunctionDecl*, std::stringstream*, SourceLocationOrder > FunctionPrologueMap;
     /// Contains only kernels.
     FunctionPrologueMap kernelPrologues_;
     /// Contains kernels and helper functions.
@@ -328,13 +471,63 @@ private:
     std::stringstream modulePrologue_;
     /// Stream for code after limit functions, eg. for builtin functions/macros
     std::stringstream afterLimitFunctions_;
+    /// Names of generated builtin wrappers keyed by their signature
+    /// and body.
+    typedef std::map<std::string, std::string> WrapperFunctionMap;
+    WrapperFunctionMap wrapperFunctions_;
   
     /// Set to ensure that we aren't initializing relocated parameters
     /// multiple times.
     std::set< clang::ParmVarDecl* > parameterRelocationInitializations_;
+    /// Memory object parameters that are padded to a power of two
+    /// number of elements.
+    std::set<const clang::ParmVarDecl*> paddedBuffers_;
+    /// Kernels that have constant region parameters.
+    std::set<const clang::FunctionDecl*> constantRegionKernels_;
+    /// Slots and functions of relocated variables that share storage.
+    typedef std::map<const clang::VarDecl*, std::pair<unsigned, std::string> > SharedSlotMap;
+    SharedSlotMap sharedSlots_;
+    /// Variables of each function that uses a shared slot, in order
+    /// of appearance.
+    typedef std::vector< std::pair<std::string, AddressSpaceInfo> > SlotGroups;
+    typedef std::map<unsigned, SlotGroups> SharedSlots;
+    /// Padded sizes of relocated fixed size arrays.
+    typedef std::map<const clang::VarDecl*, unsigned long long> PaddedArrayMap;
+    PaddedArrayMap paddedArrays_;
     /// Set to ensure that we don't have multiple type declarations
     /// with the same name.
     std::set<std::string> usedTypeNames_;
+    /// Number of variables declared for holding checked pointers.
+    unsigned checkedPointerCount_;
+    /// Whether limit checks compare unsigned offsets instead of
+    /// addresses.
+    bool unsignedOffsetChecks_;
+    /// Address spaces with more limits than this are checked by
+    /// searching a sorted table of limits. Zero disables searching.
+    unsigned limitSearchThreshold_;
+    /// Whether pointers to the main allocation structure are const
+    /// restrict pointers.
+    bool restrictAllocs_;
+    /// Whether local memory is filled with one fused routine that
+    /// uses vector stores.
+    bool fusedLocalZeroing_;
+    /// Whether only referenced general definitions are emitted and
+    /// generator comments are left out.
+    bool compactOutput_;
+    /// Whether vector loads and stores from address spaces with a
+    /// single limit are checked inside their wrappers.
+    bool inlineVectorChecks_;
+
+    /// \return Declaration of a pointer to the main allocation
+    /// structure, e.g. "_WclProgramAllocations *const restrict _wcl_allocs".
+    std::string getAddressSpaceRecordPointer() const;
+
+    /// Separates variables that use shared slots from the variables
+    /// that are placed directly into an address space structure.
+    void groupSharedSlots(AddressSpaceInfo &as, AddressSpaceInfo &unshared, SharedSlots &slots);
+    /// \return Size of relocated variable in bytes, including the
+    /// padding of padded arrays.
+    unsigned long long getFieldSize(const clang::VarDecl *decl);
 
     /// \return Address space structure, e.g. { float *a; uint b; }.
     ///
@@ -344,6 +537,16 @@ private:
     /// \return Initializer for address space structure, e.g. { NULL, 5 }.
     std::string addressSpaceInitializer(AddressSpaceInfo &as);
 
+    /// \return Whether an address space with the given number of
+    /// limits is checked by searching a sorted table of limits.
+    bool hasLimitTable(unsigned limitCount) const;
+    /// Declares a table for the sorted limits of an address space in
+    /// the main allocation structure if the limits are searched.
+    void createLimitTableField(AddressSpaceLimits &limits);
+    /// Fills and sorts the limit table of an address space at kernel
+    /// entry if the limits are searched.
+    void createLimitTableInitializer(std::ostream &out, AddressSpaceLimits &limits);
+
     /// \return Address space limits structure. Contains begin and end
     /// pointer fields for each disjoint memory area in the address
     /// space.
@@ -356,6 +559,17 @@ private:
     void createAddressSpaceLimitsNullInitializer(
         std::ostream &out, unsigned addressSpace);
 
+    /// Inserts code in front of a statement of a block. Code in front
+    /// of the first statement of a function body is added to the
+    /// function prologue, because it may depend on the address space
+    /// record declared there.
+    void insertBeforeStatement(const clang::FunctionDecl *func,
+                               clang::CompoundStmt *block, clang::Stmt *stmt,
+                               const std::string &code);
+    /// \return Declaration of a variable for holding checked pointers
+    /// of the given memory access.
+    std::string getCheckedPointerDeclaration(clang::Expr *access, const std::string &name);
+
     /// \brief Inserts module prologue to start of module.
     bool rewritePrologue();
     /// \brief Inserts kernel prologue to start of kernel body.
@@ -386,10 +600,15 @@ private:
     /// \return A full expression (incorporating a macro call from
     /// getClampFunctionCall) call that forces the given address to point to a safe
     /// memory area.
-    std::string getClampFunctionExpression(clang::Expr *access, unsigned size, AddressSpaceLimits &limits);
+    std::string getClampFunctionExpression(clang::Expr *access, unsigned size, AddressSpaceLimits &limits,
+                                           const std::string &checkedPointer);
 
     /// \brief Writes bytestream generated from general.cl to stream.
     void emitGeneralCode(std::ostream &out);
+    /// \brief Writes only those definitions of general.cl that the
+    /// given code refers to, directly or through other definitions,
+    /// without comments.
+    void emitGeneralCode(std::ostream &out, const std::string &code);
   
     /// \brief Goes through the set of all generated _wcl_addr_* calls
     /// and writes corresponding _wcl_addr_* functions to the stream.
@@ -422,8 +641,17 @@ private:
 
     typedef std::list<FunctionCallWrapper*> FunctionCallWrapperList;
 
-    /// Map from a function name to a wrapping handler
+    /// All wrapping handlers in the order of precedence.
     FunctionCallWrapperList functionWrappers_;
+    /// Named wrappers indexed by the name of the wrapped function, in
+    /// the order of functionWrappers_.
+    typedef llvm::StringMap<FunctionCallWrapperList> FunctionCallWrapperIndex;
+    FunctionCallWrapperIndex namedWrappers_;
+    /// Wrappers that need to inspect each call or declaration.
+    FunctionCallWrapperList unnamedWrappers_;
+
+    /// \return First wrapper that handles the given call or 0.
+    FunctionCallWrapper *findCallWrapper(clang::CallExpr *expr);
 };
 
 #endif // WEBCLVALIDATOR_WEBCLTRANSFORMER
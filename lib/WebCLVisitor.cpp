@@ -23,6 +23,7 @@
 
 #include "WebCLVisitor.hpp"
 #include "WebCLDebug.hpp"
+#include "WebCLOptions.hpp"
 #include "WebCLTypes.hpp"
 
 #include "clang/AST/Attr.h"
@@ -31,6 +32,8 @@
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Basic/OpenCL.h"
 
+#include <algorithm>
+
 // WebCLVisitor
 
 WebCLVisitor::WebCLVisitor(clang::CompilerInstance &instance)
@@ -409,6 +412,7 @@ bool WebCLAnalyser::handleUnaryOperator(clang::UnaryOperator *expr)
       clang::VarDecl *varDecl = llvm::dyn_cast<clang::VarDecl>(valueDecl);
       if (varDecl) {
           declarationsWithAddressOfAccess_.insert(varDecl);
+          addressReferences_[varDecl].insert(expr);
           // Add variable to corresponding address space record if its
           // address is required.
           collectVariable(varDecl);
@@ -445,6 +449,8 @@ WebCLAnalyser::KernelArgInfo::KernelArgInfo(clang::CompilerInstance &instance, c
     , reducedTypeName(WebCLTypes::reduceType(instance, decl->getType()).getAsString())
     , pointerKind(WebCLTypes::NOT_POINTER)
     , imageKind(WebCLTypes::NOT_IMAGE)
+    , isPadded(false)
+    , inConstantRegion(false)
 {
     if (typeShorthands().count(reducedTypeName)) {
         reducedTypeName = typeShorthands()[reducedTypeName];
@@ -471,6 +477,15 @@ WebCLAnalyser::KernelArgInfo::KernelArgInfo(clang::CompilerInstance &instance, c
             pointerKind = WebCLTypes::PRIVATE_POINTER;
         }
     }
+
+    inConstantRegion =
+        (pointerKind == WebCLTypes::CONSTANT_POINTER) &&
+        WebCLOptions(instance).isEnabled(WebCLOptions::constantRegion_);
+    isPadded =
+        ((pointerKind == WebCLTypes::GLOBAL_POINTER) ||
+         (pointerKind == WebCLTypes::CONSTANT_POINTER)) &&
+        !inConstantRegion &&
+        WebCLOptions(instance).isEnabled(WebCLOptions::paddedBuffers_);
 }
 
 WebCLAnalyser::KernelInfo::KernelInfo(clang::CompilerInstance &instance, clang::FunctionDecl *decl)
@@ -712,11 +727,253 @@ bool WebCLAnalyser::hasAddressReferences(clang::VarDecl *decl)
     return declarationsWithAddressOfAccess_.count(decl) > 0;
 }
 
+clang::VarDecl *WebCLAnalyser::getIndexedArray(clang::Expr *access)
+{
+    clang::ArraySubscriptExpr *subscript =
+        llvm::dyn_cast<clang::ArraySubscriptExpr>(access);
+    if (!subscript)
+        return NULL;
+
+    clang::DeclRefExpr *declRef =
+        llvm::dyn_cast<clang::DeclRefExpr>(subscript->getBase()->IgnoreParenImpCasts());
+    if (!declRef)
+        return NULL;
+
+    clang::VarDecl *decl = llvm::dyn_cast<clang::VarDecl>(declRef->getDecl());
+    if (!decl || !instance_.getASTContext().getAsConstantArrayType(decl->getType()))
+        return NULL;
+    return decl;
+}
+
+bool WebCLAnalyser::isConstantIndexInBounds(clang::Expr *access)
+{
+    clang::VarDecl *decl = getIndexedArray(access);
+    if (!decl)
+        return false;
+
+    clang::ASTContext &context = instance_.getASTContext();
+    const clang::ConstantArrayType *arrayType =
+        context.getAsConstantArrayType(decl->getType());
+    clang::Expr *index = llvm::cast<clang::ArraySubscriptExpr>(access)->getIdx();
+
+    llvm::APSInt value;
+    if (index->isValueDependent() || !index->isIntegerConstantExpr(value, context))
+        return false;
+    if (value.isSigned() && value.isNegative())
+        return false;
+    return value.getLimitedValue() < arrayType->getSize().getZExtValue();
+}
+
+bool WebCLAnalyser::isSafeBuiltinCall(clang::CallExpr *call)
+{
+    clang::FunctionDecl *callee = call->getDirectCallee();
+    if (!callee || !builtins_.isSafe(callee->getNameInfo().getAsString()))
+        return false;
+
+    // The builtin must access exactly the variable whose address is
+    // passed, not a reinterpretation of it.
+    clang::ASTContext &context = instance_.getASTContext();
+    bool hasPointers = false;
+    for (unsigned i = 0; i < call->getNumArgs(); ++i) {
+        clang::Expr *arg = call->getArg(i);
+        if (!arg->getType()->isPointerType())
+            continue;
+        clang::VarDecl *var = getAddressedVariable(arg);
+        if (!var || !context.hasSameUnqualifiedType(var->getType(), arg->getType()->getPointeeType()))
+            return false;
+        hasPointers = true;
+    }
+    return hasPointers;
+}
+
+bool WebCLAnalyser::isSafePointerParameter(const clang::ParmVarDecl *parm)
+{
+    const clang::PointerType *pointer = parm->getType()->getAs<clang::PointerType>();
+    if (!pointer || pointer->getPointeeType().getAddressSpace())
+        return false;
+    clang::QualType pointee = pointer->getPointeeType();
+    if (!pointee->isArithmeticType() && !pointee->isVectorType())
+        return false;
+
+    const clang::FunctionDecl *func = llvm::dyn_cast<clang::FunctionDecl>(parm->getDeclContext());
+    if (!func)
+        return false;
+
+    // all uses must be dereferences, e.g. p = q, p + 1 or p[0] aren't
+    unsigned derefs = 0;
+    for (MemoryAccessMap::iterator i = pointerAccesses_.begin();
+         i != pointerAccesses_.end(); ++i) {
+        clang::UnaryOperator *deref = llvm::dyn_cast<clang::UnaryOperator>(i->first);
+        if (!deref || (deref->getOpcode() != clang::UO_Deref))
+            continue;
+        clang::DeclRefExpr *declRef =
+            llvm::dyn_cast<clang::DeclRefExpr>(deref->getSubExpr()->IgnoreParenImpCasts());
+        if (declRef && (declRef->getDecl() == parm))
+            ++derefs;
+    }
+    unsigned uses = 0;
+    for (DeclRefExprSet::iterator i = variableUses_.begin(); i != variableUses_.end(); ++i) {
+        if ((*i)->getDecl() == parm)
+            ++uses;
+    }
+    if (uses != derefs)
+        return false;
+
+    // all calls must pass the address of a whole variable
+    const unsigned index = parm->getFunctionScopeIndex();
+    clang::ASTContext &context = instance_.getASTContext();
+    for (CallExprSet::iterator i = internalCalls_.begin(); i != internalCalls_.end(); ++i) {
+        clang::FunctionDecl *callee = (*i)->getDirectCallee();
+        if (!callee || (callee->getCanonicalDecl() != func->getCanonicalDecl()))
+            continue;
+        if (index >= (*i)->getNumArgs())
+            return false;
+        clang::VarDecl *var = getAddressedVariable((*i)->getArg(index));
+        if (!var || !context.hasSameUnqualifiedType(var->getType(), pointee))
+            return false;
+    }
+    return true;
+}
+
+bool WebCLAnalyser::hasOnlySafeAddressReferences(clang::VarDecl *decl)
+{
+    AddressReferenceMap::iterator references = addressReferences_.find(decl);
+    if (references == addressReferences_.end())
+        return false;
+    if (decl->getType().isVolatileQualified() ||
+        (!decl->getType()->isArithmeticType() && !decl->getType()->isVectorType()))
+        return false;
+
+    std::set<clang::Expr*> safeReferences;
+    for (CallExprSet::iterator i = builtinCalls_.begin(); i != builtinCalls_.end(); ++i) {
+        if (!isSafeBuiltinCall(*i))
+            continue;
+        for (unsigned j = 0; j < (*i)->getNumArgs(); ++j) {
+            clang::Expr *arg = (*i)->getArg(j);
+            if (getAddressedVariable(arg) == decl)
+                safeReferences.insert(arg->IgnoreParenImpCasts());
+        }
+    }
+    for (CallExprSet::iterator i = internalCalls_.begin(); i != internalCalls_.end(); ++i) {
+        clang::FunctionDecl *callee = (*i)->getDirectCallee();
+        const clang::FunctionDecl *definition = NULL;
+        if (!callee || !callee->hasBody(definition))
+            continue;
+        const unsigned params = std::min((*i)->getNumArgs(), definition->getNumParams());
+        for (unsigned j = 0; j < params; ++j) {
+            clang::Expr *arg = (*i)->getArg(j);
+            if ((getAddressedVariable(arg) == decl) &&
+                isSafePointerParameter(definition->getParamDecl(j)))
+                safeReferences.insert(arg->IgnoreParenImpCasts());
+        }
+    }
+    // every recorded address reference must be safe
+    for (std::set<clang::Expr*>::iterator i = references->second.begin();
+         i != references->second.end(); ++i) {
+        if (!safeReferences.count(*i))
+            return false;
+    }
+    return true;
+}
+
 bool WebCLAnalyser::isInsideForStmt(clang::VarDecl *decl)
 {
     return declarationsMadeInForStatements_.count(decl) > 0;
 }
 
+bool WebCLAnalyser::isInside(clang::SourceLocation location, clang::Decl *decl)
+{
+    clang::SourceManager &manager = instance_.getSourceManager();
+    location = manager.getExpansionLoc(location);
+    const clang::SourceLocation begin = manager.getExpansionLoc(decl->getLocStart());
+    const clang::SourceLocation end = manager.getExpansionLoc(decl->getLocEnd());
+    return !manager.isBeforeInTranslationUnit(location, begin) &&
+        !manager.isBeforeInTranslationUnit(end, location);
+}
+
+namespace {
+    clang::SourceLocation getNodeLocation(clang::Decl *decl)
+    {
+        return decl->getLocation();
+    }
+
+    clang::SourceLocation getNodeLocation(clang::Stmt *stmt)
+    {
+        return stmt->getLocStart();
+    }
+
+    template <typename Key, typename Value>
+    clang::SourceLocation getNodeLocation(const std::pair<Key, Value> &node)
+    {
+        return getNodeLocation(node.first);
+    }
+}
+
+template <typename Nodes>
+void WebCLAnalyser::removeNodesInside(Nodes &nodes, clang::Decl *decl)
+{
+    Nodes kept;
+    for (typename Nodes::iterator i = nodes.begin(); i != nodes.end(); ++i) {
+        if (!isInside(getNodeLocation(*i), decl))
+            kept.insert(kept.end(), *i);
+    }
+    nodes.swap(kept);
+}
+
+void WebCLAnalyser::removeHelperFunctions(const FunctionDeclSet &functions)
+{
+    for (FunctionDeclSet::const_iterator i = functions.begin();
+         i != functions.end(); ++i) {
+        helperFunctions_.erase(*i);
+        removeFunctionNodes(*i);
+    }
+}
+
+void WebCLAnalyser::removeKernelFunctions(const FunctionDeclSet &kernels)
+{
+    KernelList kept;
+    for (KernelList::iterator i = kernelFunctions_.begin();
+         i != kernelFunctions_.end(); ++i) {
+        if (!kernels.count(i->decl))
+            kept.push_back(*i);
+    }
+    kernelFunctions_.swap(kept);
+
+    for (FunctionDeclSet::const_iterator i = kernels.begin();
+         i != kernels.end(); ++i) {
+        kernelSet_.erase(*i);
+        removeFunctionNodes(*i);
+    }
+}
+
+void WebCLAnalyser::removeFunctionNodes(clang::FunctionDecl *decl)
+{
+    if (!decl->doesThisDeclarationHaveABody())
+        return;
+
+    // Forget everything that was collected from the body so that
+    // later passes don't transform code that is going to be removed.
+    removeNodesInside(internalCalls_, decl);
+    removeNodesInside(builtinCalls_, decl);
+    removeNodesInside(constantVariables_, decl);
+    removeNodesInside(localVariables_, decl);
+    removeNodesInside(privateVariables_, decl);
+    removeNodesInside(declarationsWithAddressOfAccess_, decl);
+    removeNodesInside(addressReferences_, decl);
+    removeNodesInside(declarationsMadeInForStatements_, decl);
+    removeNodesInside(variableUses_, decl);
+    removeNodesInside(pointerAccesses_, decl);
+    removeNodesInside(typeDeclList_, decl);
+}
+
+void WebCLAnalyser::removeConstantVariables(const VarDeclSet &variables)
+{
+    for (VarDeclSet::const_iterator i = variables.begin();
+         i != variables.end(); ++i) {
+        constantVariables_.erase(*i);
+    }
+}
+
 bool WebCLAnalyser::hasUnsafeParameters(clang::CallExpr *callExpr)
 {
     clang::FunctionDecl *decl = callExpr->getDirectCallee();
@@ -738,6 +995,24 @@ bool WebCLAnalyser::hasUnsafeParameters(clang::CallExpr *callExpr)
     return false;
 }
 
+clang::VarDecl *WebCLAnalyser::getAddressedVariable(clang::Expr *expr)
+{
+    clang::UnaryOperator *addressOf =
+        llvm::dyn_cast<clang::UnaryOperator>(expr->IgnoreParenImpCasts());
+    if (!addressOf || (addressOf->getOpcode() != clang::UO_AddrOf))
+        return NULL;
+    clang::DeclRefExpr *declRef =
+        llvm::dyn_cast<clang::DeclRefExpr>(addressOf->getSubExpr()->IgnoreParens());
+    if (!declRef)
+        return NULL;
+    clang::VarDecl *decl = llvm::dyn_cast<clang::VarDecl>(declRef->getDecl());
+    if (!decl || !isPrivate(decl))
+        return NULL;
+    if (!decl->getType()->isArithmeticType() && !decl->getType()->isVectorType())
+        return NULL;
+    return decl;
+}
+
 bool WebCLAnalyser::isPrivate(clang::VarDecl *decl) const
 {
     return decl->getType().getAddressSpace() == 0;
@@ -25,6 +25,7 @@
 */
 
 #include "WebCLBuiltins.hpp"
+#include "WebCLHelper.hpp"
 #include "WebCLReporter.hpp"
 #include "WebCLTypes.hpp"
 
@@ -234,6 +235,12 @@ public:
       WebCLTypes::PointerKind pointerKind;
       /// Is this an image arg, and if so, with which access qualifiers
       WebCLTypes::ImageKind imageKind;
+      /// Must the memory object be padded to a power of two number
+      /// of elements
+      bool isPadded;
+      /// Is the memory object bound into the constant region of the
+      /// kernel instead of being passed with its own size
+      bool inConstantRegion;
 
       KernelArgInfo(clang::CompilerInstance &instance, clang::ParmVarDecl *decl);
   };
@@ -249,17 +256,17 @@ public:
       KernelInfo(clang::CompilerInstance &instance, clang::FunctionDecl *decl);
   };
 
-  typedef std::set<clang::FunctionDecl*> FunctionDeclSet;
+  typedef std::set<clang::FunctionDecl*, SourceLocationOrder> FunctionDeclSet;
   typedef std::vector<KernelInfo> KernelList;
-  typedef std::set<clang::CallExpr*> CallExprSet;
-  typedef std::set<clang::VarDecl*> VarDeclSet;
-  typedef std::set<clang::DeclRefExpr*> DeclRefExprSet;
+  typedef std::set<clang::CallExpr*, SourceLocationOrder> CallExprSet;
+  typedef std::set<clang::VarDecl*, SourceLocationOrder> VarDeclSet;
+  typedef std::set<clang::DeclRefExpr*, SourceLocationOrder> DeclRefExprSet;
   typedef std::vector<clang::TypeDecl*> TypeDeclList;
 
   /// Memory accesses and corresponding declarations, this will change
   /// if separate dependence analysis is added to resolve which limits
   /// each memory access should respect.
-  typedef std::map<clang::Expr*, clang::VarDecl*> MemoryAccessMap;
+  typedef std::map<clang::Expr*, clang::VarDecl*, SourceLocationOrder> MemoryAccessMap;
   
   /// Accessors for collected data.
   KernelList &getKernelFunctions();
@@ -288,6 +295,36 @@ public:
   /// \return Whether address of variable is taken.
   bool hasAddressReferences(clang::VarDecl *decl);
 
+  /// \return Fixed size array variable that the memory access
+  /// indexes directly, e.g. a[i] or i[a], or NULL if the access is
+  /// something else.
+  clang::VarDecl *getIndexedArray(clang::Expr *access);
+
+  /// \return Whether the memory access indexes a fixed size array
+  /// with an integer constant expression that is within the array
+  /// bounds. Such accesses can't go out of bounds.
+  bool isConstantIndexInBounds(clang::Expr *access);
+
+  /// \return Whether each pointer argument of a safe builtin call
+  /// is the address of a private scalar or vector variable of the
+  /// type that the builtin accesses, e.g. sincos(x, &c). The builtin
+  /// can only write to that variable.
+  bool isSafeBuiltinCall(clang::CallExpr *call);
+
+  /// \return Whether the private pointer parameter of a helper
+  /// function is only dereferenced, e.g. *p = 0, and whether each
+  /// call of the helper function passes the address of a variable
+  /// of the pointee type to it, e.g. f(&x).
+  bool isSafePointerParameter(const clang::ParmVarDecl *parm);
+
+  /// \return Whether the address of a private scalar or vector
+  /// variable is only passed to safe builtin calls or safe pointer
+  /// parameters. Such variables don't need to be relocated.
+  ///
+  /// \see isSafeBuiltinCall
+  /// \see isSafePointerParameter
+  bool hasOnlySafeAddressReferences(clang::VarDecl *decl);
+
   /// \return Whether variable has been declared in first for clause.
   bool isInsideForStmt(clang::VarDecl *decl);
 
@@ -295,6 +332,23 @@ public:
   /// function declaration takes pointer parameters.
   bool hasUnsafeParameters(clang::CallExpr *expr);
   
+  /// \return Whether the location is within the source range of the
+  /// declaration.
+  bool isInside(clang::SourceLocation location, clang::Decl *decl);
+
+  /// Forget helper functions that won't be part of the validated
+  /// program, and all nodes that have been collected from their
+  /// bodies.
+  void removeHelperFunctions(const FunctionDeclSet &functions);
+
+  /// Forget kernels that won't be part of the validated program,
+  /// and all nodes that have been collected from their bodies.
+  void removeKernelFunctions(const FunctionDeclSet &kernels);
+
+  /// Forget constant variables that won't be part of the validated
+  /// program.
+  void removeConstantVariables(const VarDeclSet &variables);
+
   /// \return True if name is name of a kernel function.
   bool isKernel(clang::FunctionDecl *decl) {
     return kernelSet_.count(decl) > 0;
@@ -307,6 +361,18 @@ private:
 
   /// Save variable into address space specific variable collection.
   void collectVariable(clang::VarDecl *decl);
+
+  /// \return Private scalar or vector variable whose address the
+  /// expression takes, e.g. &x, or NULL if the expression is
+  /// something else.
+  clang::VarDecl *getAddressedVariable(clang::Expr *expr);
+
+  /// Erase nodes that are located within the declaration.
+  template <typename Nodes>
+  void removeNodesInside(Nodes &nodes, clang::Decl *decl);
+
+  /// Erase nodes that have been collected from the function body.
+  void removeFunctionNodes(clang::FunctionDecl *decl);
   
   /// User defined kernels.
   KernelList kernelFunctions_;
@@ -326,6 +392,9 @@ private:
   VarDeclSet privateVariables_;
   /// Variables whose address has been taken with the & operator.
   VarDeclSet declarationsWithAddressOfAccess_;
+  /// Expressions taking the address of each variable.
+  typedef std::map<clang::VarDecl*, std::set<clang::Expr*> > AddressReferenceMap;
+  AddressReferenceMap addressReferences_;
   /// Variables declared in the first for clause.
   VarDeclSet declarationsMadeInForStatements_;
   /// All uses of variable declarations.
@@ -26,6 +26,7 @@
 #include "WebCLTool.hpp"
 
 #include <cassert>
+#include <cctype>
 #include <cstdlib>
 #include <iostream>
 #include <set>
@@ -34,6 +35,7 @@
 
 #include "WebCLArguments.hpp"
 #include "WebCLDiag.hpp"
+#include "WebCLOptions.hpp"
 #include "WebCLVisitor.hpp"
 
 struct WebCLValidator
@@ -53,6 +55,8 @@ public:
     const std::string &getValidatedSource() const { return validatedSource_; }
     /// Ditto for kernel info
     const WebCLAnalyser::KernelList &getKernels() const { return kernels_; }
+    /// Ditto for digest of validated source and kernel info
+    const std::string &getProgramHash() const { return programHash_; }
 
     unsigned getNumWarnings() const { return diag->getNumWarnings(); }
     unsigned getNumErrors() const { return diag->getNumErrors(); }
@@ -71,6 +75,8 @@ private:
     std::string validatedSource_;
     /// Ditto for kernel info
     WebCLAnalyser::KernelList kernels_;
+    /// Ditto for digest
+    std::string programHash_;
 };
 
 WebCLValidator::WebCLValidator(
@@ -209,6 +215,7 @@ void WebCLValidator::run()
     const int validatorStatus = validatorTool.run();
     validatedSource_ = validatorTool.getValidatedSource();
     kernels_ = validatorTool.getKernels();
+    programHash_ = validatorTool.getProgramHash();
     exitStatus_ = validatorStatus;
 }
 
@@ -219,6 +226,34 @@ CLV_API extern "C" clv_program CLV_CALL clvValidate(
     void (CL_CALLBACK *pfn_notify)(clv_program program, void *user_data),
     void *notify_data,
     cl_int *errcode_ret)
+{
+    return clvValidateKernels(
+        input_source, active_extensions, user_defines, NULL,
+        pfn_notify, notify_data, errcode_ret);
+}
+
+namespace
+{
+    bool isIdentifier(const char *name)
+    {
+        if (!name || !(std::isalpha(static_cast<unsigned char>(*name)) || (*name == '_')))
+            return false;
+        while (*(++name)) {
+            if (!(std::isalnum(static_cast<unsigned char>(*name)) || (*name == '_')))
+                return false;
+        }
+        return true;
+    }
+}
+
+CLV_API extern "C" clv_program CLV_CALL clvValidateKernels(
+    const char *input_source,
+    const char **active_extensions,
+    const char **user_defines,
+    const char **kernel_names,
+    void (CL_CALLBACK *pfn_notify)(clv_program program, void *user_data),
+    void *notify_data,
+    cl_int *errcode_ret)
 {
     if (!input_source || !*input_source) {
         if (errcode_ret)
@@ -226,16 +261,34 @@ CLV_API extern "C" clv_program CLV_CALL clvValidate(
         return NULL;
     }
 
+    // The kernels are passed to the validator as a comma separated
+    // list, so the names must be plain identifiers.
+    std::string kernels;
+    while (kernel_names && *kernel_names) {
+        if (!isIdentifier(*kernel_names)) {
+            if (errcode_ret)
+                *errcode_ret = CL_INVALID_VALUE;
+            return NULL;
+        }
+        if (!kernels.empty())
+            kernels += ",";
+        kernels += *(kernel_names++);
+    }
+
     std::set<std::string> extensions;
     while (active_extensions && *active_extensions)
         extensions.insert(*(active_extensions++));
 
-    std::set<std::string> defineArgs;
+    // Keep the order of user defines so that later definitions
+    // override earlier ones.
+    std::vector<std::string> defineArgs;
     while (user_defines && *user_defines)
-        defineArgs.insert(std::string("-D") + *(user_defines++));
+        defineArgs.push_back(std::string("-D") + *(user_defines++));
+    if (!kernels.empty())
+        defineArgs.push_back(std::string("-D") + WebCLOptions::kernels_ + "=" + kernels);
 
     std::vector<const char *> argv;
-    for (std::set<std::string>::const_iterator i = defineArgs.begin(); i != defineArgs.end(); ++i)
+    for (std::vector<std::string>::const_iterator i = defineArgs.begin(); i != defineArgs.end(); ++i)
         argv.push_back(i->c_str());
 
     WebCLValidator *validator = new WebCLValidator(input_source, extensions, argv.size(), argv.empty() ? NULL : &argv[0]);
@@ -556,6 +609,44 @@ CLV_API extern "C" cl_kernel_arg_address_qualifier CLV_CALL clvGetKernelArgAddre
     }
 }
 
+CLV_API extern "C" cl_bool CLV_CALL clvKernelArgIsPadded(
+    clv_program program,
+    cl_uint kernel,
+    cl_uint arg)
+{
+    if (!program)
+        return CL_FALSE;
+
+    const WebCLAnalyser::KernelList &kernels = program->getKernels();
+
+    if (kernel >= kernels.size())
+        return CL_FALSE;
+
+    if (arg >= kernels[kernel].args.size())
+        return CL_FALSE;
+
+    return kernels[kernel].args[arg].isPadded ? CL_TRUE : CL_FALSE;
+}
+
+CLV_API extern "C" cl_bool CLV_CALL clvKernelArgIsInConstantRegion(
+    clv_program program,
+    cl_uint kernel,
+    cl_uint arg)
+{
+    if (!program)
+        return CL_FALSE;
+
+    const WebCLAnalyser::KernelList &kernels = program->getKernels();
+
+    if (kernel >= kernels.size())
+        return CL_FALSE;
+
+    if (arg >= kernels[kernel].args.size())
+        return CL_FALSE;
+
+    return kernels[kernel].args[arg].inConstantRegion ? CL_TRUE : CL_FALSE;
+}
+
 CLV_API extern "C" cl_bool CLV_CALL clvKernelArgIsImage(
     clv_program program,
     cl_uint kernel,
@@ -623,6 +714,25 @@ CLV_API cl_int CLV_CALL clvGetProgramValidatedSource(
     return returnString(source, source_buf_size, source_buf, source_size_ret);
 }
 
+CLV_API cl_int CLV_CALL clvGetProgramHash(
+    clv_program program,
+    size_t hash_buf_size,
+    char *hash_buf,
+    size_t *hash_size_ret)
+{
+    if (!program)
+        return CL_INVALID_PROGRAM;
+
+    if (hash_buf && !hash_buf_size)
+        return CL_INVALID_VALUE;
+
+    std::string hash;
+    if (program->getExitStatus() == EXIT_SUCCESS)
+        hash = program->getProgramHash();
+
+    return returnString(hash, hash_buf_size, hash_buf, hash_size_ret);
+}
+
 CLV_API extern "C" void CLV_CALL clvReleaseProgram(
     clv_program program)
 {
@@ -15,6 +15,7 @@ typedef uint _WclInitType;
 #ifdef cl_khr_initialize_memory
 #pragma OPENCL EXTENSION cl_khr_initialize_memory : enable
 #define _WCL_LOCAL_RANGE_INIT(begin, end)
+#define _WCL_LOCAL_RANGE_FILL(begin, end, item_index, item_count)
 #else
 
 // be careful to edit this, this has been carefully tuned to work on every OpenCL driver
@@ -42,8 +43,71 @@ typedef uint _WclInitType;
     }                                                                   \
 } while (0)                                                             \
 
+// Fills a local memory range with all work-items of a work-group,
+// which are identified by a flattened index and count that are
+// computed once for all ranges. The 16 byte aligned middle of the
+// range is filled with vector stores so that neighbouring work-items
+// write neighbouring vectors. Unaligned bytes at both edges are
+// filled one by one.
+#define _WCL_LOCAL_RANGE_FILL(begin, end, item_index, item_count) do {    \
+    __local uchar *start = (__local uchar *)(begin);                      \
+    __local uchar *stop = (__local uchar *)(end);                         \
+    __local uchar *head = start + ((16 - ((size_t)start & 15)) & 15);     \
+    __local uchar *tail = stop - ((size_t)stop & 15);                     \
+    if (head > tail) {                                                    \
+        head = stop;                                                      \
+        tail = stop;                                                      \
+    }                                                                     \
+    for (size_t i = (item_index); i < (size_t)(head - start); i += (item_count)) \
+        start[i] = _WCL_FILLCHAR;                                         \
+    __local uint4 *bulk = (__local uint4 *)head;                          \
+    const uint4 fill = (uint4)(_WCL_FILLCHAR * 0x01010101u);              \
+    for (size_t i = (item_index); i < (size_t)(tail - head) / 16; i += (item_count)) \
+        bulk[i] = fill;                                                   \
+    for (size_t i = (item_index); i < (size_t)(stop - tail); i += (item_count)) \
+        tail[i] = _WCL_FILLCHAR;                                          \
+} while (0)
+
 #endif // cl_khr_initialize_memory
 
+// Zeroes a private memory range. The range is contiguous, so the
+// loop can be turned into a few wide stores.
+#define _WCL_PRIVATE_RANGE_ZERO(begin, end) do {                    \
+    __private uchar *start = (__private uchar *)(begin);            \
+    __private uchar *stop = (__private uchar *)(end);               \
+    for (__private uchar *p = start; p < stop; ++p)                 \
+        *p = 0;                                                     \
+} while (0)
+
+// Stores a (min, max) pair to a table of limits that is searched
+// instead of checking each limit separately.
+#define _WCL_SET_LIMIT(table, index, min, max) do { \
+    (table)[2 * (index)] = (ulong)(min);            \
+    (table)[2 * (index) + 1] = (ulong)(max);        \
+} while (0)
+
+// Sorts a table of (min, max) pairs by their minimums. Each maximum is
+// then raised to the largest maximum before it, so that the last pair
+// starting at or below an address covers the address whenever any of
+// the original pairs does, even if the memory areas overlap.
+#define _WCL_SORT_LIMITS(table, count) do {                        \
+    for (uint i = 1; i < (count); ++i) {                           \
+        const ulong lo = (table)[2 * i];                           \
+        const ulong hi = (table)[2 * i + 1];                       \
+        uint j = i;                                                \
+        for (; (j > 0) && ((table)[2 * (j - 1)] > lo); --j) {      \
+            (table)[2 * j] = (table)[2 * (j - 1)];                 \
+            (table)[2 * j + 1] = (table)[2 * (j - 1) + 1];         \
+        }                                                          \
+        (table)[2 * j] = lo;                                       \
+        (table)[2 * j + 1] = hi;                                   \
+    }                                                              \
+    for (uint i = 1; i < (count); ++i) {                           \
+        (table)[2 * i + 1] =                                       \
+            max((table)[2 * i + 1], (table)[2 * (i - 1) + 1]);     \
+    }                                                              \
+} while (0)
+
 constant int hd4k_workaround_constant = 0;
 
 // <= General code that doesn't depend on input.
@@ -139,7 +139,7 @@ bool testSource(cl_device_id device, std::string const& source, bool isTransform
         std::cout << "Build ok!" << std::endl;
     }
 
-    cl_command_queue command_queue = clCreateCommandQueue(context, device, 0, &ret);
+    cl_command_queue command_queue = clCreateCommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, &ret);
 
     const int Length = 100;
     cl_mem outArg0 = clCreateBuffer(context, CL_MEM_WRITE_ONLY, Length * sizeof(cl_int), NULL, &ret);
@@ -158,22 +158,47 @@ bool testSource(cl_device_id device, std::string const& source, bool isTransform
     args.appendLocalArray<cl_float>(Length);
     args.appendLocalArray<cl_float4>(Length);
 
-    // Execute the OpenCL kernel on the list
-    size_t global_item_size = 100; // Process the entire lists
-    size_t local_item_size = 20; // Divide work items into groups of 20
-    ret = clEnqueueNDRangeKernel(command_queue, kernel, 1,
-                                 NULL, &global_item_size, &local_item_size,
-                                 0, NULL, NULL);
+    size_t max_local_item_size = 0;
+    clGetKernelWorkGroupInfo(kernel, device, CL_KERNEL_WORK_GROUP_SIZE,
+                             sizeof(max_local_item_size), &max_local_item_size, NULL);
 
+    // Execute the OpenCL kernel on the list with different work-group
+    // sizes and report how long each run takes, zeroing included.
     bool testPass = true;
-    if (ret != CL_SUCCESS)
-    {
-        std::cerr << "clEnqueueNDRangeKernel failed with code " << ret << std::endl;
-    }
-    else
+    size_t global_item_size = 100; // Process the entire lists
+    const size_t local_item_sizes[] = { 1, 4, 20, 50, 100 };
+    const size_t num_local_item_sizes = sizeof(local_item_sizes) / sizeof(local_item_sizes[0]);
+    for (size_t i = 0; i < num_local_item_sizes; ++i)
     {
+        size_t local_item_size = local_item_sizes[i];
+        if (local_item_size > max_local_item_size)
+            continue;
+
+        cl_event event = NULL;
+        ret = clEnqueueNDRangeKernel(command_queue, kernel, 1,
+                                     NULL, &global_item_size, &local_item_size,
+                                     0, NULL, &event);
+
+        if (ret != CL_SUCCESS)
+        {
+            std::cerr << "clEnqueueNDRangeKernel failed with code " << ret << std::endl;
+            continue;
+        }
+
         ret = clFinish(command_queue);
 
+        cl_ulong started = 0;
+        cl_ulong ended = 0;
+        if ((CL_SUCCESS == clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START,
+                                                   sizeof(started), &started, NULL)) &&
+            (CL_SUCCESS == clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END,
+                                                   sizeof(ended), &ended, NULL)))
+        {
+            std::cout << "Work-group size " << local_item_size << ": "
+                      << (ended - started) << " ns" << std::endl;
+        }
+        clReleaseEvent(event);
+
         unsigned char *buf = new unsigned char[Length * sizeof(cl_float4)]; // allocate by largest buffer
         int sizeInBytes = Length * sizeof(cl_int);
         ret = clEnqueueReadBuffer(command_queue, outArg0, CL_TRUE, 0, sizeInBytes, buf, 0, NULL, NULL);
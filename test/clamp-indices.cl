@@ -0,0 +1,26 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_CLAMP_INDICES | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_CLAMP_INDICES | grep -v CHECK | %FileCheck "%s"
+
+// CHECK-NOT: _wcl_lut
+__constant float lut[4] = { 0.0f, 0.25f, 0.5f, 0.75f };
+
+__kernel void clamp_indices(
+    __global float *array)
+{
+    __local float scratch[2];
+    const int i = get_global_id(0);
+
+    // CHECK: const float weights[3] = { 1.0f, 2.0f, 1.0f };
+    const float weights[3] = { 1.0f, 2.0f, 1.0f };
+
+    // arrays that are only indexed directly aren't relocated
+    // CHECK: float sum = (lut)[(uint)(i) & 3u] + (weights)[min((uint)(i + 1), 2u)];
+    float sum = lut[i] + weights[i + 1];
+
+    // CHECK: (_wcl_locals._wcl_scratch)[(uint)(i) & 1u] = sum;
+    scratch[i] = sum;
+
+    // CHECK: _wcl_addr_clamp_global_{{.*}}((array)+(i), 1, {{.*}} = (_wcl_locals._wcl_scratch)[(uint)(i - 1) & 1u];
+    array[i] = scratch[i - 1];
+}
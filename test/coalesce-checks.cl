@@ -0,0 +1,50 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_COALESCE_CHECKS | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_COALESCE_CHECKS | grep -v CHECK | %FileCheck "%s"
+
+typedef struct {
+    float a;
+    float b;
+} Pair;
+
+__kernel void coalesce_checks(
+    __global float *array, __global Pair *pairs)
+{
+    // CHECK: __global float *_wcl_checked_ptr_0 = _wcl_addr_clamp_global_2_{{.*}}((array)+(i)+(-1), 5,
+    const int i = get_global_id(0);
+
+    // CHECK: const float sum = (*((_wcl_checked_ptr_0)+1)) + (*((_wcl_checked_ptr_0)+2)) + (*((_wcl_checked_ptr_0)+3)) + (*((_wcl_checked_ptr_0)+4));
+    const float sum = array[i] + array[i + 1] + array[i + 2] + array[i + 3];
+    // CHECK: const float edge = (*(_wcl_checked_ptr_0));
+    const float edge = array[i - 1];
+    float result = sum + edge;
+
+    // conditional accesses don't widen the checked range
+    if (i > 0)
+        // CHECK: result += (*(_wcl_addr_clamp_global_2_{{.*}}((array)+(i + 8), 1,
+        result += array[i + 8];
+
+    // CHECK: (*((_wcl_checked_ptr_0)+1)) = result;
+    // CHECK: __global Pair *_wcl_checked_ptr_1 = _wcl_addr_clamp_global_2_{{.*}}((pairs)+(i), 1,
+    array[i] = result;
+
+    // CHECK: (*(_wcl_checked_ptr_1)).a = (*(_wcl_checked_ptr_1)).b;
+    pairs[i].a = pairs[i].b;
+}
+
+__kernel void large_offsets(
+    __global float *array)
+{
+    const long i = get_global_id(0);
+
+    // offsets that are too large to be coalesced are checked separately
+    // CHECK: const float a = (*(_wcl_addr_clamp_global_{{.*}}((array)+(i), 1,
+    const float a = array[i];
+    // CHECK: const float b = (*(_wcl_addr_clamp_global_{{.*}}((array)+(i + 4294967296L), 1,
+    const float b = array[i + 4294967296L];
+    // CHECK: const float c = (*(_wcl_addr_clamp_global_{{.*}}((array)+(i - 2147483648L), 1,
+    const float c = array[i - 2147483648L];
+    // CHECK: const float d = (*(_wcl_addr_clamp_global_{{.*}}((array)+(i + 2147483647L), 1,
+    const float d = array[i + 2147483647L];
+    array[0] = a + b + c + d;
+}
@@ -0,0 +1,20 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_COMPACT_OUTPUT | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_COMPACT_OUTPUT | grep -v CHECK | %FileCheck "%s"
+
+// CHECK-NOT: WebCL Validator
+// CHECK-NOT: General code that doesn't depend on input
+// CHECK-NOT: _WclInitType
+// CHECK-NOT: _WCL_LOCAL_RANGE_INIT
+// CHECK-NOT: _WCL_MEMCPY
+// CHECK: #define _WCL_SET_NULL(
+// CHECK-NOT: Local memory zeroing
+// CHECK: {{^}}return atomic_inc(_
+// CHECK: __kernel void compact_output(
+
+__kernel void compact_output(__global int *output, __global int *input)
+{
+    const int i = get_global_id(0);
+    output[i] = input[i];
+    atomic_inc(output);
+}
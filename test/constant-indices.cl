@@ -0,0 +1,33 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_CONSTANT_INDICES | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_CONSTANT_INDICES | grep -v CHECK | %FileCheck "%s"
+
+// CHECK-NOT: _wcl_lut
+__constant float lut[4] = { 0.0f, 0.25f, 0.5f, 0.75f };
+
+__kernel void constant_indices(
+    __global float *array)
+{
+    __local float scratch[2];
+    const int i = get_global_id(0);
+
+    // CHECK: const float weights[3] = { 1.0f, 2.0f, 1.0f };
+    const float weights[3] = { 1.0f, 2.0f, 1.0f };
+    const float steps[2] = { 0.5f, 1.5f };
+
+    // arrays that are only indexed with constants aren't relocated
+    // CHECK: float sum = lut[0] + lut[3] + weights[0] + weights[1 + 1];
+    float sum = lut[0] + lut[3] + weights[0] + weights[1 + 1];
+
+    // other arrays are relocated, but accesses with constant
+    // indices still don't need to be checked
+    // CHECK: sum += _wcl_allocs->pa._wcl_steps[1];
+    sum += steps[1];
+    // CHECK: sum += (*(_wcl_addr_clamp_private_{{.*}}((_wcl_allocs->pa._wcl_steps)+(i & 1), 1,
+    sum += steps[i & 1];
+    // CHECK: _wcl_locals._wcl_scratch[0] = sum;
+    scratch[0] = sum;
+
+    // CHECK: _wcl_addr_clamp_global_{{.*}}((array)+(i), 1, {{.*}} = _wcl_locals._wcl_scratch[1];
+    array[i] = scratch[1];
+}
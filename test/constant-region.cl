@@ -0,0 +1,41 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_CONSTANT_REGION | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_CONSTANT_REGION | grep -v CHECK | %FileCheck "%s"
+
+// Constant memory objects have no size parameters and are listed as
+// members of the constant region, which follows the other parameters.
+// CHECK: "constant_region" :
+// CHECK: "coefficients" :
+// CHECK: "constant-region" : "_wcl_constant_region"
+// CHECK: "offsets" :
+// CHECK: "constant-region" : "_wcl_constant_region"
+// CHECK: "count" :
+// CHECK: "index" : 4,
+// CHECK: "_wcl_constant_region" :
+// CHECK: "index" : 5,
+// CHECK: "size-parameter" : "_wcl_constant_region_size",
+// CHECK: "members" : [ "coefficients", "offsets" ]
+// CHECK: "_wcl_constant_region_size" :
+// CHECK: "index" : 6,
+
+// CHECK: __constant uchar *_wcl_constant_region_min;
+// CHECK-NEXT: __constant uchar *_wcl_constant_region_max;
+// CHECK-NOT: coefficients_min
+
+// CHECK: __kernel void constant_region(
+// CHECK-NEXT: __global float *output, ulong _wcl_output_size,
+// CHECK-NEXT: __constant float *coefficients, __constant int *offsets,
+// CHECK-NEXT: int count, __constant uchar *_wcl_constant_region, ulong _wcl_constant_region_size)
+__kernel void constant_region(
+    __global float *output,
+    __constant float *coefficients, __constant int *offsets,
+    int count)
+{
+    // CHECK: &_wcl_constant_region[0], &_wcl_constant_region[_wcl_constant_region_size]
+    const int i = get_global_id(0);
+
+    // Both constant memory objects are checked against the region.
+    // CHECK: _wcl_addr_clamp_constant_1__u_uconstant__float__Ptr((coefficients)+(i % count), 1, (__constant float *)_wcl_allocs->cl._wcl_constant_region_min, (__constant float *)_wcl_allocs->cl._wcl_constant_region_max
+    // CHECK: _wcl_addr_clamp_constant_1__u_uconstant__int__Ptr((offsets)+(i), 1, (__constant int *)_wcl_allocs->cl._wcl_constant_region_min, (__constant int *)_wcl_allocs->cl._wcl_constant_region_max
+    output[i] = coefficients[i % count] * offsets[i];
+}
@@ -0,0 +1,21 @@
+// RUN: %opencl-validator < "%s"
+// RUN: for input in "%S"/*.cl; do %webcl-validator "$input" > "%t.first" 2>&1; %webcl-validator "$input" > "%t.second" 2>&1; cmp "%t.first" "%t.second" || exit 1; done
+
+// Validating any input twice must give identical output, including
+// the names and order of generated wrappers and relocated variables.
+
+int helper(__global int *array, int i)
+{
+    return vload4(0, array + i).x + vload4(1, array + i).y;
+}
+
+__kernel void deterministic_output(__global int *array)
+{
+    __local int shared[4];
+    int private_array[4] = { 0 };
+
+    const int i = get_global_id(0);
+    shared[i % 4] = helper(array, i);
+    private_array[i % 4] = shared[(i + 1) % 4];
+    vstore4(vload4(0, private_array), i, array);
+}
@@ -0,0 +1,43 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_ESCAPE_ANALYSIS | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_ESCAPE_ANALYSIS | grep -v CHECK | %FileCheck "%s"
+
+// CHECK-NOT: _wcl_cosine
+// CHECK-NOT: _wcl_sum
+// CHECK: _wcl_escaped
+
+// prototypes for apple driver
+void accumulate(float *sum, float value);
+void escape(float *pointer, int index);
+
+void accumulate(float *sum, float value)
+{
+    // CHECK: *sum = *sum + value;
+    *sum = *sum + value;
+}
+
+void escape(float *pointer, int index)
+{
+    pointer[index] = 0.0f;
+}
+
+__kernel void escape_analysis(
+    __global float *output)
+{
+    const int i = get_global_id(0);
+
+    // CHECK: float cosine;
+    float cosine;
+    // CHECK: float sine = sincos((float)i, &cosine);
+    float sine = sincos((float)i, &cosine);
+
+    float sum = 0.0f;
+    accumulate(&sum, sine);
+    accumulate(&sum, cosine);
+
+    // passing the address to escape() relocates the variable
+    float escaped = 1.0f;
+    escape(&escaped, i);
+
+    output[i] = sum + escaped;
+}
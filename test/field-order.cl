@@ -0,0 +1,22 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" | %opencl-validator
+// RUN: %webcl-validator "%s" | grep -v CHECK | %FileCheck "%s"
+
+// fields are sorted by decreasing alignment and size
+// CHECK: typedef struct {
+// CHECK-NEXT: float4 _wcl_vectors[2];
+// CHECK-NEXT: int _wcl_large[3];
+// CHECK-NEXT: int _wcl_small[2];
+// CHECK-NEXT: char _wcl_bytes[3];
+// CHECK-NEXT: } __attribute__ ((aligned ({{.*}}))) _WclPrivates;
+
+__kernel void field_order(
+    __global float *output, int index)
+{
+    char bytes[3] = { 1, 2, 3 };
+    int small[2] = { 4, 5 };
+    float4 vectors[2] = { (float4)(6.0f), (float4)(7.0f) };
+    int large[3] = { 8, 9, 10 };
+
+    output[0] = bytes[index] + small[index] + vectors[index].x + large[index];
+}
@@ -0,0 +1,23 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_FUSED_LOCAL_ZEROING | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_FUSED_LOCAL_ZEROING | grep -v CHECK | %FileCheck "%s"
+
+__kernel void fused_local_zeroing(
+    __global int *output, __local int *scratch)
+{
+    __local int table[10];
+
+    // CHECK: // => Local memory zeroing.
+    // CHECK-NEXT: const size_t _wcl_local_item_index =
+    // CHECK-NEXT: const size_t _wcl_local_item_count =
+    // CHECK-NEXT: _WCL_LOCAL_RANGE_FILL(_wcl_allocs->ll._wcl_locals_min, _wcl_allocs->ll._wcl_locals_max, _wcl_local_item_index, _wcl_local_item_count);
+    // CHECK-NEXT: _WCL_LOCAL_RANGE_FILL({{.+}}, _wcl_local_item_index, _wcl_local_item_count);
+    // CHECK-NEXT: _WCL_LOCAL_RANGE_FILL({{.+}}, _wcl_local_item_index, _wcl_local_item_count);
+    // CHECK-NEXT: barrier(CLK_LOCAL_MEM_FENCE);
+    // CHECK-NEXT: // <= Local memory zeroing.
+
+    const int i = get_local_id(0);
+    table[i % 10] = scratch[i];
+    barrier(CLK_LOCAL_MEM_FENCE);
+    output[get_global_id(0)] = table[(i + 1) % 10];
+}
@@ -0,0 +1,31 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_INLINE_VECTOR_CHECKS | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_INLINE_VECTOR_CHECKS | grep -v CHECK | %FileCheck "%s"
+// RUN: %webcl-validator "%s" -DWCLV_INLINE_VECTOR_CHECKS | %kernel-runner --webcl --kernel inline_vector_checks --constant float 7 | grep '^1,2,3,4,0,0,1,1,1,1,0'
+// RUN: %webcl-validator "%s" -DWCLV_INLINE_VECTOR_CHECKS | %kernel-runner --webcl --kernel inline_vector_checks --constant float 8 | grep '^1,2,3,4,0,0,5,6,7,8,0'
+
+// Constant and local memory both have a single limit, so the wrappers
+// check accesses themselves instead of calling check functions.
+// CHECK-DAG: return ((4 * sizeof(*ptr) <= ((ulong)({{.*}}) - (ulong)({{.*}}))) & (((ulong)(ptr) - (ulong)({{.*}})) <= (((ulong)({{.*}}) - (ulong)({{.*}})) - 4 * sizeof(*ptr)))) ? vload4(0, ptr) : (float) 0;
+// CHECK-DAG: if ((4 * sizeof(*ptr) <= ((ulong)({{.*}}) - (ulong)({{.*}}))) & (((ulong)(ptr) - (ulong)({{.*}})) <= (((ulong)({{.*}}) - (ulong)({{.*}})) - 4 * sizeof(*ptr))))
+// CHECK-DAG: vstore4(arg0, 0, ptr);
+
+__kernel void inline_vector_checks(__global char *output, __constant float *input)
+{
+    __local float scratch[6];
+
+    const float4 first = vload4(0, input);
+    const float4 second = vload4(1, input);
+
+    // The second store doesn't fit and is skipped completely.
+    vstore4(first + 1, 0, scratch);
+    vstore4(second + 1, 1, scratch);
+
+    for (int i = 0; i < 6; ++i)
+        output[i] = scratch[i];
+
+    output[6] = second.x + 1;
+    output[7] = second.y + 1;
+    output[8] = second.z + 1;
+    output[9] = second.w + 1;
+}
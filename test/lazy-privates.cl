@@ -0,0 +1,36 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_LAZY_PRIVATES | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_LAZY_PRIVATES | grep -v CHECK | %FileCheck "%s"
+
+__kernel void lazy_privates(
+    __global float *output, __global float *input, int index)
+{
+    // CHECK: _WclProgramAllocations _wcl_allocations_allocation;
+    // CHECK-NEXT: _wcl_allocations_allocation.gl = (_WclGlobalLimits){
+    // CHECK-NEXT: _wcl_allocations_allocation.gn = 0;
+    // CHECK-NEXT: _wcl_allocations_allocation.pn = 0;
+    // CHECK-NEXT: _WclProgramAllocations *_wcl_allocs = &_wcl_allocations_allocation;
+    // CHECK-NEXT: _WCL_PRIVATE_RANGE_ZERO(&_wcl_allocs->pa, &_wcl_allocs->pa._wcl_scratch);
+    // CHECK-NEXT: _WCL_PRIVATE_RANGE_ZERO((&_wcl_allocs->pa._wcl_scratch + 1), &_wcl_allocs->pa._wcl_weights);
+    // CHECK-NEXT: _WCL_PRIVATE_RANGE_ZERO((&_wcl_allocs->pa._wcl_weights + 1), (&_wcl_allocs->pa + 1));
+
+    const int i = get_global_id(0);
+
+    float scratch[256];
+    for (int j = 0; j < 256; ++j)
+        scratch[j] = input[i + j];
+
+    float weights[3];
+    weights[0] = 0.25f;
+    weights[1] = 0.5f;
+    weights[2] = 0.25f;
+
+    // read before being written, so it's still zeroed
+    float history[4];
+    history[index] = scratch[index];
+
+    float sum = 0.0f;
+    for (int j = 1; j < 255; ++j)
+        sum += weights[0] * scratch[j - 1] + weights[1] * scratch[j] + weights[2] * scratch[j + 1];
+    output[i] = sum + history[i % 4];
+}
@@ -0,0 +1,27 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_PAD_LOCALS=64 | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_PAD_LOCALS=64 | grep -v CHECK | %FileCheck "%s"
+
+// padding of tile takes 8 bytes and padding of large would take 112
+// CHECK: typedef struct {
+// CHECK-DAG: float _wcl_tile[8];
+// CHECK-DAG: float _wcl_aligned[4];
+// CHECK-DAG: int _wcl_large[100];
+// CHECK: _WclLocals;
+
+__kernel void pad_locals(
+    __global float *output)
+{
+    __local float tile[6];
+    __local float aligned[4];
+    __local int large[100];
+    const int i = get_local_id(0);
+
+    // CHECK: (_wcl_locals._wcl_tile)[(uint)(i) & 7u] = (_wcl_locals._wcl_aligned)[(uint)(i) & 3u];
+    tile[i] = aligned[i];
+    // CHECK: _wcl_addr_clamp_local
+    large[i] = i;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    output[i] = tile[i + 1] + large[i];
+}
@@ -0,0 +1,23 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_PADDED_BUFFERS | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_PADDED_BUFFERS | grep -v CHECK | %FileCheck "%s"
+
+// CHECK: __kernel void padded_buffers(
+// CHECK: __global float *output, ulong _wcl_output_mask, __global float *input, ulong _wcl_input_mask)
+__kernel void padded_buffers(
+    __global float *output, __global float *input)
+{
+    // CHECK: &output[0], &output[_wcl_output_mask + 1]
+    // CHECK: &input[0], &input[_wcl_input_mask + 1]
+    const int i = get_global_id(0);
+
+    // accesses through unmodified parameters are masked
+    // CHECK: (output)[(i) & _wcl_output_mask] = (input)[(i + 1) & _wcl_input_mask];
+    output[i] = input[i + 1];
+
+    // accesses through other pointers are still checked
+    // CHECK: __global float *shifted = input + 2;
+    // CHECK: (output)[(i) & _wcl_output_mask] += (*(_wcl_addr_clamp_global_
+    __global float *shifted = input + 2;
+    output[i] += shifted[i];
+}
@@ -0,0 +1,77 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_REMOVE_UNUSED_CODE | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_REMOVE_UNUSED_CODE | grep -v CHECK | %FileCheck "%s"
+
+// CHECK-NOT: unused_table
+// CHECK-NOT: private_table
+// CHECK-NOT: unused_helper
+// CHECK-NOT: unused_caller
+// CHECK-NOT: unused_prototype
+// CHECK: __constant int used_table[] = { 1, 2, 3, 4 };
+__constant int used_table[] = { 1, 2, 3, 4 };
+__constant int unused_table[] = { 5, 6, 7, 8 };
+__constant int private_table[] = { 9, 10, 11, 12 };
+
+int unused_prototype(__global int *array);
+int used_prototype(__global int *array, int i);
+// functions declared together keep their declaration if any of them is used
+// CHECK: int unreached({{.*}}), reached({{.*}});
+int unreached(int x), reached(int x);
+
+int unused_helper(__global int *array, int i)
+{
+    int scratch[4] = { 0 };
+    scratch[i % 4] = array[i];
+    return scratch[(i + 1) % 4] + private_table[i % 4];
+}
+
+int unused_caller(__global int *array, int i)
+{
+    return unused_helper(array, i) + unused_prototype(array);
+}
+
+// CHECK-NOT: unused_table
+// CHECK-NOT: private_table
+// CHECK-NOT: unused_helper
+// CHECK-NOT: unused_caller
+// CHECK-NOT: unused_prototype
+// CHECK: int used_helper(_WclProgramAllocations *_wcl_allocs, __global int *array, int i)
+int used_helper(__global int *array, int i)
+{
+    return used_prototype(array, i) + used_table[i % 4] + reached(i);
+}
+
+__kernel void remove_unused_code(__global int *array)
+{
+    const int i = get_global_id(0);
+    array[i] = used_helper(array, i);
+}
+
+// CHECK-NOT: unused_table
+// CHECK-NOT: private_table
+// CHECK-NOT: unused_helper
+// CHECK-NOT: unused_caller
+// CHECK-NOT: unused_prototype
+// CHECK: int used_prototype(_WclProgramAllocations *_wcl_allocs, __global int *array, int i)
+int used_prototype(__global int *array, int i)
+{
+    return array[i];
+}
+
+// CHECK: int reached(_WclProgramAllocations *_wcl_allocs, int x)
+int reached(int x)
+{
+    return x + 1;
+}
+
+// CHECK-NOT: unreached
+int unreached(int x)
+{
+    return x - 1;
+}
+
+// CHECK-NOT: unused_prototype
+int unused_prototype(__global int *array)
+{
+    return array[0];
+}
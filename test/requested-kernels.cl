@@ -0,0 +1,46 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" --kernel=first_kernel --kernel=third_kernel | %opencl-validator
+// RUN: %webcl-validator "%s" --kernel=first_kernel --kernel=third_kernel | grep -v CHECK | %FileCheck "%s"
+// RUN: %webcl-validator "%s" --kernel=missing_kernel 2>&1 | grep "Requested kernel missing_kernel isn't defined."
+
+// CHECK-NOT: dropped_
+// CHECK: "first_kernel"
+// CHECK-NOT: dropped_
+// CHECK: "third_kernel"
+// CHECK-NOT: dropped_
+
+__constant int shared_table[] = { 1, 2, 3, 4 };
+__constant int dropped_table[] = { 5, 6, 7, 8 };
+
+int shared_helper(int i)
+{
+    return shared_table[i % 4];
+}
+
+int dropped_helper(int i)
+{
+    return dropped_table[i % 4];
+}
+
+// CHECK: __kernel void first_kernel(
+__kernel void first_kernel(__global int *array)
+{
+    const int i = get_global_id(0);
+    array[i] = shared_helper(i);
+}
+
+// CHECK-NOT: dropped_
+__kernel void dropped_kernel(__global int *array)
+{
+    const int i = get_global_id(0);
+    array[i] = shared_helper(i) + dropped_helper(i);
+}
+
+// CHECK: __kernel void third_kernel(
+__kernel void third_kernel(__global int *array)
+{
+    const int i = get_global_id(0);
+    array[i] = 2 * shared_helper(i);
+}
+
+// CHECK-NOT: dropped_
@@ -0,0 +1,24 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_RESTRICT_ALLOCS | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_RESTRICT_ALLOCS | grep -v CHECK | %FileCheck "%s"
+
+// CHECK: _wcl_vload4_{{[0-9]+}}(_WclProgramAllocations*const restrict _wcl_allocs,
+
+// prototypes for apple driver
+float sum(__global float *array, int index);
+
+float sum(
+    // CHECK: _WclProgramAllocations *const restrict _wcl_allocs, __global float *array, int index)
+    __global float *array, int index)
+{
+    float4 values = vload4(index, array);
+    return values.x + values.y + values.z + values.w;
+}
+
+__kernel void restrict_allocs(
+    __global float *output, __global float *input)
+{
+    // CHECK: _WclProgramAllocations *const restrict _wcl_allocs = &_wcl_allocations_allocation;
+    const int i = get_global_id(0);
+    output[i] = sum(input, i);
+}
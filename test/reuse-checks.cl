@@ -0,0 +1,38 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_REUSE_CHECKS | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_REUSE_CHECKS | grep -v CHECK | %FileCheck "%s"
+
+__kernel void reuse_checks(
+    __global int *array)
+{
+    // CHECK: __global int *_wcl_checked_ptr_0;
+    // CHECK: __global int *_wcl_checked_ptr_1;
+
+    const int i = get_global_id(0);
+
+    // CHECK: const int value = (*(_wcl_checked_ptr_0 = _wcl_addr_clamp_global_1__u_uglobal__int__Ptr((array)+(i), 1,
+    const int value = array[i];
+    // CHECK: (*(_wcl_checked_ptr_0)) = value + 1;
+    array[i] = value + 1;
+    // CHECK: if (value) {
+    if (value) {
+        // CHECK: (*(_wcl_checked_ptr_0)) += value;
+        array[i] += value;
+    }
+
+    int j = i;
+    // CHECK: (*(_wcl_checked_ptr_1 = _wcl_addr_clamp_global_1__u_uglobal__int__Ptr((array)+(j + 1), 1,
+    array[j + 1] = 0;
+    // CHECK: (*(_wcl_checked_ptr_1)) *= 2;
+    array[j + 1] *= 2;
+    // index changes, the address has to be checked again
+    j = value;
+    // CHECK: (*(_wcl_addr_clamp_global_1__u_uglobal__int__Ptr((array)+(j + 1), 1,
+    array[j + 1] = 1;
+
+    // conditionally evaluated accesses aren't reused
+    // CHECK: const int maybe = value > 0 ? (*(_wcl_addr_clamp_global_1__u_uglobal__int__Ptr((array)+(i + 2), 1,
+    const int maybe = value > 0 ? array[i + 2] : 0;
+    // CHECK: (*(_wcl_addr_clamp_global_1__u_uglobal__int__Ptr((array)+(i + 2), 1,
+    array[i + 2] = maybe;
+}
@@ -0,0 +1,26 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_SEARCH_LIMITS=2 | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_SEARCH_LIMITS=2 | grep -v CHECK | %FileCheck "%s"
+
+// CHECK: ulong gt[6];
+// CHECK: } _WclProgramAllocations;
+
+// CHECK: bool _wcl_addr_check_global_3__u_uglobal__float__Ptr(__global float *addr, unsigned size, const ulong *table)
+// CHECK: const ulong first = (ulong)(addr);
+// CHECK: const ulong last = first + (ulong)size * sizeof(*addr);
+// CHECK: uint i = (table[2] <= first) ? 1 : 0;
+// CHECK: i = (table[2 * (i + 1)] <= first) ? (i + 1) : i;
+// CHECK: return (table[2 * i] <= first) & (first <= last) & (last <= table[2 * i + 1]);
+
+__kernel void search_limits(
+    __global float *output, __global float *first, __global float *second)
+{
+    // CHECK: _WCL_SET_LIMIT(_wcl_allocs->gt, 0, _wcl_allocs->gl.search_limits__output_min, _wcl_allocs->gl.search_limits__output_max);
+    // CHECK: _WCL_SET_LIMIT(_wcl_allocs->gt, 1, _wcl_allocs->gl.search_limits__first_min, _wcl_allocs->gl.search_limits__first_max);
+    // CHECK: _WCL_SET_LIMIT(_wcl_allocs->gt, 2, _wcl_allocs->gl.search_limits__second_min, _wcl_allocs->gl.search_limits__second_max);
+    // CHECK: _WCL_SORT_LIMITS(_wcl_allocs->gt, 3);
+    const int i = get_global_id(0);
+
+    // CHECK: (*(_wcl_addr_clamp_global_3__u_uglobal__float__Ptr((output)+(i), 1, _wcl_allocs->gt, (__global float *)_wcl_allocs->gn))) =
+    output[i] = first[i] + second[i];
+}
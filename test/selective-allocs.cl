@@ -0,0 +1,37 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_SELECTIVE_ALLOCS | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_SELECTIVE_ALLOCS | grep -v CHECK | %FileCheck "%s"
+
+// CHECK: float square(float x)
+float square(float x)
+{
+    return x * x;
+}
+
+// CHECK: float load(_WclProgramAllocations *_wcl_allocs, __global float *array, int i)
+float load(__global float *array, int i)
+{
+    return array[i];
+}
+
+// CHECK: float load_square(_WclProgramAllocations *_wcl_allocs, __global float *array, int i)
+float load_square(__global float *array, int i)
+{
+    // CHECK: return square(load(_wcl_allocs, array, i));
+    return square(load(array, i));
+}
+
+// CHECK: float sum_squares(float x, float y)
+float sum_squares(float x, float y)
+{
+    // CHECK: return square(x) + square(y);
+    return square(x) + square(y);
+}
+
+__kernel void selective_allocs(__global float *array)
+{
+    const int i = get_global_id(0);
+    // CHECK: const float value = sum_squares(load_square(_wcl_allocs, array, i), (float)i);
+    const float value = sum_squares(load_square(array, i), (float)i);
+    array[i] = value;
+}
@@ -0,0 +1,53 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_SHARE_SLOTS | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_SHARE_SLOTS | grep -v CHECK | %FileCheck "%s"
+
+// CHECK: union {
+// CHECK: struct {
+// CHECK: } _wcl_{{first|second}};
+// CHECK: struct {
+// CHECK: } _wcl_{{first|second}};
+// CHECK: } _wcl_0slot;
+// CHECK: union {
+// CHECK: struct {
+// CHECK: int _wcl_values[4];
+// CHECK: } _wcl_helper;
+// CHECK: } _wcl_1slot;
+// CHECK: _WclPrivates;
+
+// CHECK: union {
+// CHECK: } _wcl_0slot;
+// CHECK: _WclLocals;
+
+// prototypes for apple driver
+int helper(int index);
+
+int helper(int index)
+{
+    int values[4] = { 1, 2, 3, 4 };
+    // CHECK: _wcl_allocs->pa._wcl_1slot._wcl_helper._wcl_values
+    return values[index];
+}
+
+__kernel void first(
+    __global int *output)
+{
+    __local int scratch[16];
+    int offsets[2] = { 0, 1 };
+    const int i = get_global_id(0);
+    // CHECK: _wcl_locals._wcl_0slot._wcl_first._wcl_scratch{{[_0-9]*}}
+    scratch[i] = helper(offsets[i]);
+    barrier(CLK_LOCAL_MEM_FENCE);
+    output[i] = scratch[i];
+}
+
+__kernel void second(
+    __global int *output)
+{
+    __local float scratch[8];
+    float weights[3] = { 1.0f, 2.0f, 1.0f };
+    const int i = get_global_id(0);
+    scratch[i] = weights[i];
+    barrier(CLK_LOCAL_MEM_FENCE);
+    output[i] = helper(i) + scratch[i];
+}
@@ -0,0 +1,97 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_SKIP_WRITTEN_LOCALS | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_SKIP_WRITTEN_LOCALS | grep -v CHECK | %FileCheck "%s"
+
+__kernel __attribute__((reqd_work_group_size(8, 8, 1)))
+void transpose(
+    __global float *output, __global float *input, int width)
+{
+    __local float tile[8][8];
+
+    // CHECK: // => Local memory zeroing.
+    // CHECK-NEXT: _WCL_LOCAL_RANGE_INIT(&_wcl_locals, &_wcl_locals._wcl_tile);
+    // CHECK-NEXT: _WCL_LOCAL_RANGE_INIT((&_wcl_locals._wcl_tile + 1), (&_wcl_locals + 1));
+    // CHECK-NEXT: _WCL_LOCAL_RANGE_INIT(_wcl_local_null,
+    // CHECK-NEXT: // <= Local memory zeroing.
+
+    tile[get_local_id(1)][get_local_id(0)] =
+        input[get_global_id(1) * width + get_global_id(0)];
+    barrier(CLK_LOCAL_MEM_FENCE);
+    output[get_global_id(0) * width + get_global_id(1)] =
+        tile[get_local_id(0)][get_local_id(1)];
+}
+
+__kernel void reduce(
+    __global float *output, __global float *input)
+{
+    __local float scratch[64];
+
+    // CHECK: // => Local memory zeroing.
+    // CHECK-NEXT: _WCL_LOCAL_RANGE_INIT(&_wcl_locals, &_wcl_locals._wcl_scratch);
+    // CHECK-NEXT: _WCL_LOCAL_RANGE_INIT((&_wcl_locals._wcl_scratch + 1), (&_wcl_locals + 1));
+    // CHECK-NEXT: _WCL_LOCAL_RANGE_INIT(_wcl_local_null,
+    // CHECK-NEXT: // <= Local memory zeroing.
+
+    for (int i = get_local_id(0); i < 64; i += get_local_size(0))
+        scratch[i] = input[get_group_id(0) * 64 + i];
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (get_local_id(0) == 0) {
+        float sum = 0;
+        for (int i = 0; i < 64; ++i)
+            sum += scratch[i];
+        output[get_group_id(0)] = sum;
+    }
+}
+
+__kernel void partial(
+    __global int *output)
+{
+    __local int part[4];
+
+    // CHECK: // => Local memory zeroing.
+    // CHECK-NEXT: _WCL_LOCAL_RANGE_INIT(_wcl_allocs->ll._wcl_locals_min, _wcl_allocs->ll._wcl_locals_max);
+    // CHECK-NEXT: _WCL_LOCAL_RANGE_INIT(_wcl_local_null,
+    // CHECK-NEXT: barrier(CLK_LOCAL_MEM_FENCE);
+
+    const size_t i = get_local_id(0);
+    if (i < 4)
+        part[i] = i;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    output[get_global_id(0)] = part[i % 4];
+}
+
+typedef struct {
+    char c;
+    int i;
+} Pair;
+
+// Elements with padding are still zeroed, because assigning them
+// doesn't have to write the padding bytes.
+__kernel __attribute__((reqd_work_group_size(8, 1, 1)))
+void padded_vectors(
+    __global float *output)
+{
+    __local float3 vectors[8];
+
+    // CHECK: // => Local memory zeroing.
+    // CHECK-NEXT: _WCL_LOCAL_RANGE_INIT(_wcl_allocs->ll._wcl_locals_min, _wcl_allocs->ll._wcl_locals_max);
+
+    vectors[get_local_id(0)] = (float3)(1.0f);
+    barrier(CLK_LOCAL_MEM_FENCE);
+    output[get_global_id(0)] = vectors[7 - get_local_id(0)].x;
+}
+
+__kernel void padded_structures(
+    __global int *output, __global Pair *input)
+{
+    __local Pair pairs[16];
+
+    // CHECK: // => Local memory zeroing.
+    // CHECK-NEXT: _WCL_LOCAL_RANGE_INIT(_wcl_allocs->ll._wcl_locals_min, _wcl_allocs->ll._wcl_locals_max);
+
+    for (int i = get_local_id(0); i < 16; i += get_local_size(0))
+        pairs[i] = input[i];
+    barrier(CLK_LOCAL_MEM_FENCE);
+    output[get_global_id(0)] = pairs[get_local_id(0) % 16].i;
+}
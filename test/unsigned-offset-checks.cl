@@ -0,0 +1,19 @@
+// RUN: %opencl-validator < "%s"
+// RUN: %webcl-validator "%s" -DWCLV_UNSIGNED_OFFSET_CHECKS | %opencl-validator
+// RUN: %webcl-validator "%s" -DWCLV_UNSIGNED_OFFSET_CHECKS | grep -v CHECK | %FileCheck "%s"
+
+// CHECK: bool _wcl_addr_check_global_2__u_uglobal__float__Ptr(__global float *addr, unsigned size, __global float *min0, __global float *max0, __global float *min1, __global float *max1)
+// CHECK: const ulong bytes = (ulong)size * sizeof(*addr);
+// CHECK: const ulong span0 = (ulong)(max0) - (ulong)(min0);
+// CHECK: const ulong span1 = (ulong)(max1) - (ulong)(min1);
+// CHECK: return 0
+// CHECK: | ( (bytes <= span0) & (((ulong)(addr) - (ulong)(min0)) <= (span0 - bytes)) )
+// CHECK: | ( (bytes <= span1) & (((ulong)(addr) - (ulong)(min1)) <= (span1 - bytes)) );
+
+__kernel void unsigned_offset_checks(
+    __global float *output, __global float *input)
+{
+    const int i = get_global_id(0);
+    // CHECK: (*(_wcl_addr_clamp_global_2__u_uglobal__float__Ptr((output)+(i), 1,
+    output[i] = input[i];
+}
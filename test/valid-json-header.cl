@@ -111,6 +111,7 @@ __kernel void json_vectors(
 
 // CHECK:{
 // CHECK:    "version" : "1.0",
+// CHECK:    "hash" : "{{[0-9a-f]+}}",
 // CHECK:    "kernels" :
 // CHECK:        {
 // CHECK:            "json_builtins" :